@@ -0,0 +1,614 @@
+/** @file bench.c
+ *  @brief Benchmarks of the fast paths against the code they replaced
+ *
+ *  @author Georg Pohl
+ *
+ *  @bug no known bugs
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Built with 'make bench', not part of myProgram. Without arguments
+ *  all benchmarks run, otherwise the ones named:
+ *
+ *    ./bench uptime
+ *
+ *  Every benchmark times the old and the new path on the same
+ *  generated input, prints both times and the speedup, and compares
+ *  the results of the two; a mismatch makes the run fail. Where the
+ *  old implementation was replaced in ganylib.c, it is kept here as
+ *  'old_*'.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "ganylib.h"
+
+/* CONSTANTS */
+
+#define BENCH_UPTIME_ROUTERS 200000
+#define BENCH_CONFIG_INTERFACES 100000
+#define BENCH_SEARCH_ROUNDS 5
+#define BENCH_CASE_ROUNDS 10
+#define BENCH_SORT_SMALL 20000
+#define BENCH_SORT_LARGE 2000000
+#define BENCH_TABLE_SIZE (1 << 24)
+#define BENCH_LOOKUPS 4000000
+
+/* STRUCTS */
+
+typedef struct {
+  const char *name;
+  bool (*run)(void);
+} bench_entry;
+
+/* FUNCTIONS */
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void report(const char *what, double old_ms, double new_ms) {
+  printf("  %-40s old %9.1f ms  new %9.1f ms  %6.1fx\n", what, old_ms, new_ms,
+         new_ms > 0.0 ? old_ms / new_ms : 0.0);
+}
+
+static bool check(bool ok, const char *what) {
+  if (!ok) {
+    printf("  MISMATCH: %s\n", what);
+  }
+  return ok;
+}
+
+/* Small deterministic generator, so every run sees the same input */
+static unsigned int bench_seed = 12345;
+
+static unsigned int bench_rand(void) {
+  bench_seed = bench_seed * 1103515245u + 12345u;
+  return bench_seed >> 8;
+}
+
+/* Creates a temporary file, its name is written to 'path' */
+static FILE *bench_tmpfile(char *path, size_t size) {
+  const char *dir = getenv("TMPDIR");
+  snprintf(path, size, "%s/bench_XXXXXX", dir ? dir : "/tmp");
+  int fd = mkstemp(path);
+  FILE *fp = fd < 0 ? NULL : fdopen(fd, "w");
+  if (fp == NULL) {
+    perror("bench_tmpfile");
+  }
+  return fp;
+}
+
+/*
+ * uptime: bulk extraction (user-007) against the per-line path it
+ * replaced: getline(), strstr() for "uptime is" and the old strtok
+ * based 'extract_router_uptime'.
+ */
+
+static int old_extract_router_uptime(char* line) {
+  int years = 0, weeks = 0, days = 0;
+  char* token = strtok(line, " ,");
+  int last_number = 0;
+  while (token != NULL) {
+    if (strcmp(token, "year") == 0 || strcmp(token, "years") == 0) {
+      years = last_number;
+    } else if (strcmp(token, "week") == 0 || strcmp(token, "weeks") == 0) {
+      weeks = last_number;
+    } else if (strcmp(token, "day") == 0 || strcmp(token, "days") == 0) {
+      days = last_number;
+    } else {
+      last_number = atoi(token);
+    }
+    token = strtok(NULL, " ,");
+  }
+  return years * 365 + weeks * 7 + days + 1;
+}
+
+static bool bench_uptime(void) {
+  char path[256];
+  FILE *fp = bench_tmpfile(path, sizeof(path));
+  if (fp == NULL) {
+    return false;
+  }
+  for (int r = 0; r < BENCH_UPTIME_ROUTERS; ++r) {
+    fprintf(fp, "Cisco IOS XR Software, Version 7.%u.%u\n"
+                "Copyright (c) 2013-2026 by Cisco Systems, Inc.\n\n"
+                "ROM: System Bootstrap, Version 1.%u\n\n",
+            bench_rand() % 10, bench_rand() % 10, bench_rand() % 60);
+    fprintf(fp, "router%d uptime is %u years, %u weeks, %u days, %u hours, "
+                "%u minutes\n",
+            r, bench_rand() % 8, bench_rand() % 52, bench_rand() % 7,
+            bench_rand() % 24, bench_rand() % 60);
+    fprintf(fp, "System image file is \"bootflash:asr9k-os-mbi-7.3.2\"\n"
+                "cisco ASR9K Series (Intel 686 F6M14S4) processor with "
+                "12582912K bytes of memory.\n"
+                "4 Management Ethernet\n"
+                "2 TenGigE\n\n");
+  }
+  fclose(fp);
+  struct stat st;
+  stat(path, &st);
+  printf("  %d records, %.1f MB\n", BENCH_UPTIME_ROUTERS, st.st_size / 1e6);
+
+  double t = now_ms();
+  long old_days = 0, old_n = 0;
+  fp = fopen(path, "r");
+  char *line = NULL;
+  size_t cap = 0;
+  while (fp != NULL && getline(&line, &cap, fp) != -1) {
+    char *p = strstr(line, "uptime is");
+    if (p != NULL) {
+      old_days += old_extract_router_uptime(p + 9);
+      old_n++;
+    }
+  }
+  free(line);
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  double old_ms = now_ms() - t;
+
+  bool ok = true;
+  unsigned int threads[2] = { 1, 0 };
+  for (int k = 0; k < 2; ++k) {
+    uptime_dump dump;
+    t = now_ms();
+    int n = extract_uptimes_from_file(path, threads[k], &dump);
+    double new_ms = now_ms() - t;
+    long new_days = 0;
+    for (int i = 0; i < n; ++i) {
+      new_days += dump.records[i].uptime_minutes / (24 * 60) + 1;
+    }
+    report(k == 0 ? "extract_uptimes_from_file, 1 thread"
+                  : "extract_uptimes_from_file, all CPUs", old_ms, new_ms);
+    ok &= check(n == old_n && new_days == old_days, "uptime records");
+    if (n >= 0) {
+      uptime_dump_free(&dump);
+    }
+  }
+  unlink(path);
+  return ok;
+}
+
+/*
+ * search: 'search_pattern_in_string' (user-008) against its old
+ * double loop, on a generated router configuration.
+ */
+
+static int old_search_pattern_in_string(char *source_string, char *search_pattern) {
+  if (source_string == NULL || search_pattern == NULL) {
+    return -2;
+  }
+  int source_length = (int)strlen(source_string);
+  int pattern_length = (int)strlen(search_pattern);
+  if (pattern_length > source_length) {
+    return -1;
+  }
+  for (size_t i = 0; i <= source_length - pattern_length; ++i) {
+    size_t j;
+    for (j = 0; j < pattern_length; ++j) {
+      if (source_string[i + j] != search_pattern[j]) {
+        break;
+      }
+    }
+    if (j == pattern_length) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Returns a NUL-terminated configuration with one block per interface */
+static char *bench_config(size_t *len) {
+  size_t cap = (size_t)BENCH_CONFIG_INTERFACES * 256 + 64;
+  char *text = malloc(cap);
+  size_t n = 0;
+  for (int i = 0; text != NULL && i < BENCH_CONFIG_INTERFACES; ++i) {
+    n += snprintf(text + n, cap - n,
+                  "interface TenGigE0/%d/0/%d\n"
+                  " description Link to core-%u port %u\n"
+                  " mtu 9192\n"
+                  " ipv4 address 10.%u.%u.%u 255.255.255.252\n"
+                  " load-interval 30\n"
+                  "!\n",
+                  i / 48, i % 48, bench_rand() % 100, bench_rand() % 48,
+                  bench_rand() % 200, bench_rand() % 256, bench_rand() % 256);
+  }
+  *len = n;
+  return text;
+}
+
+static bool bench_search(void) {
+  size_t len;
+  char *config = bench_config(&len);
+  if (config == NULL) {
+    return false;
+  }
+  printf("  %.1f MB of configuration\n", len / 1e6);
+
+  // A unique block at the end, so both searches scan all text
+  strcpy(config + len, "interface Bundle-Ether999\n description Uplink\n!\n");
+  char *patterns[] = { "Bundle-Ether999",
+                       "interface Bundle-Ether999\n description Link to core",
+                       "router bgp 65000", "e" };
+  const char *names[] = { "short pattern at the end", "long pattern, absent",
+                          "absent pattern", "single byte at the start" };
+
+  bool ok = true;
+  for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); ++p) {
+    int old_pos = 0, new_pos = 0;
+    double t = now_ms();
+    for (int r = 0; r < BENCH_SEARCH_ROUNDS; ++r) {
+      old_pos = old_search_pattern_in_string(config, patterns[p]);
+    }
+    double old_ms = now_ms() - t;
+    t = now_ms();
+    for (int r = 0; r < BENCH_SEARCH_ROUNDS; ++r) {
+      new_pos = search_pattern_in_string(config, patterns[p]);
+    }
+    report(names[p], old_ms, now_ms() - t);
+    ok &= check(old_pos == new_pos, names[p]);
+  }
+  free(config);
+  return ok;
+}
+
+/*
+ * case: the ASCII case conversions (user-015) against the old
+ * tolower()/toupper() loops, on the same configuration text.
+ */
+
+static void old_make_string_lwrcase(char *str) {
+  while (*str) {
+    *str = tolower((unsigned int) *str);
+    str++;
+  }
+}
+
+static void old_make_string_uprcase(char *str) {
+  while (*str) {
+    *str = toupper((unsigned int) *str);
+    str++;
+  }
+}
+
+static bool bench_case(void) {
+  size_t len;
+  char *a = bench_config(&len);
+  char *b = malloc(len + 1);
+  char *c = malloc(len + 1);
+  if (a == NULL || b == NULL || c == NULL) {
+    free(a);
+    free(b);
+    free(c);
+    return false;
+  }
+  memcpy(b, a, len + 1);
+  printf("  %.1f MB, lower and upper case %d times\n", len / 1e6, BENCH_CASE_ROUNDS);
+
+  double t = now_ms();
+  for (int r = 0; r < BENCH_CASE_ROUNDS; ++r) {
+    old_make_string_lwrcase(a);
+    old_make_string_uprcase(a);
+  }
+  double old_ms = now_ms() - t;
+  t = now_ms();
+  for (int r = 0; r < BENCH_CASE_ROUNDS; ++r) {
+    make_string_lwrcase(b);
+    make_string_uprcase(b);
+  }
+  report("make_string_lwrcase/uprcase", old_ms, now_ms() - t);
+  bool ok = check(memcmp(a, b, len) == 0, "make_string_lwrcase/uprcase");
+
+  t = now_ms();
+  for (int r = 0; r < BENCH_CASE_ROUNDS; ++r) {
+    ascii_lowercase(b, len);
+    ascii_uppercase(b, len);
+  }
+  report("ascii_lowercase/uppercase (length known)", old_ms, now_ms() - t);
+  ok &= check(memcmp(a, b, len) == 0, "ascii_lowercase/uppercase");
+
+  // Copying: the old way is strcpy() followed by the conversion
+  t = now_ms();
+  for (int r = 0; r < BENCH_CASE_ROUNDS; ++r) {
+    strcpy(c, b);
+    old_make_string_lwrcase(c);
+  }
+  old_ms = now_ms() - t;
+  old_make_string_lwrcase(a);
+  t = now_ms();
+  for (int r = 0; r < BENCH_CASE_ROUNDS; ++r) {
+    ascii_lowercase_copy(c, b, len);
+  }
+  report("ascii_lowercase_copy", old_ms, now_ms() - t);
+  ok &= check(memcmp(a, c, len) == 0, "ascii_lowercase_copy");
+
+  free(a);
+  free(b);
+  free(c);
+  return ok;
+}
+
+/*
+ * sort: 'intro_sort' (user-021) against the four existing sorts. The
+ * quadratic ones get BENCH_SORT_SMALL elements, 'shell_sort' also
+ * BENCH_SORT_LARGE ones in random, sorted and reversed order.
+ */
+
+typedef int (*int_sort_fn)(int *array, int n);
+
+static int double_compare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void fill_ints(int *array, size_t n, int order) {
+  for (size_t i = 0; i < n; ++i) {
+    array[i] = order == 0 ? (int)bench_rand() : order == 1 ? (int)i : (int)(n - i);
+  }
+}
+
+/* Sorts a copy of 'input' with 'old' and with 'intro_sort' */
+static bool bench_sort_one(const char *what, int_sort_fn old, const int *input,
+                           size_t n) {
+  int *a = malloc(n * sizeof(int));
+  int *b = malloc(n * sizeof(int));
+  if (a == NULL || b == NULL) {
+    free(a);
+    free(b);
+    return false;
+  }
+  memcpy(a, input, n * sizeof(int));
+  memcpy(b, input, n * sizeof(int));
+  double t = now_ms();
+  old(a, (int)n);
+  double old_ms = now_ms() - t;
+  t = now_ms();
+  intro_sort(b, n, NULL);
+  report(what, old_ms, now_ms() - t);
+  bool ok = check(memcmp(a, b, n * sizeof(int)) == 0, what);
+  free(a);
+  free(b);
+  return ok;
+}
+
+static bool bench_sort(void) {
+  static const struct {
+    const char *name;
+    int_sort_fn sort;
+  } small[] = {
+    { "insertion_sort, 20K random", insertion_sort },
+    { "bubble_sort, 20K random", bubble_sort },
+    { "selection_sort, 20K random", selection_sort },
+    { "shell_sort, 20K random", shell_sort },
+  };
+  static const char *large[] = { "shell_sort, 2M random", "shell_sort, 2M sorted",
+                                 "shell_sort, 2M reversed" };
+  int *input = malloc(BENCH_SORT_LARGE * sizeof(int));
+  double *d = malloc(BENCH_SORT_LARGE * sizeof(double));
+  double *e = malloc(BENCH_SORT_LARGE * sizeof(double));
+  if (input == NULL || d == NULL || e == NULL) {
+    free(input);
+    free(d);
+    free(e);
+    return false;
+  }
+  printf("  old: the existing sort, new: intro_sort\n");
+
+  bool ok = true;
+  fill_ints(input, BENCH_SORT_SMALL, 0);
+  for (size_t k = 0; k < sizeof(small) / sizeof(small[0]); ++k) {
+    ok &= bench_sort_one(small[k].name, small[k].sort, input, BENCH_SORT_SMALL);
+  }
+  for (int order = 0; order < 3; ++order) {
+    fill_ints(input, BENCH_SORT_LARGE, order);
+    ok &= bench_sort_one(large[order], shell_sort, input, BENCH_SORT_LARGE);
+  }
+
+  // There is no old sort for doubles, libc's qsort() is the reference
+  for (size_t i = 0; i < BENCH_SORT_LARGE; ++i) {
+    d[i] = e[i] = bench_rand() / 1e3;
+  }
+  double t = now_ms();
+  qsort(d, BENCH_SORT_LARGE, sizeof(double), double_compare);
+  double old_ms = now_ms() - t;
+  t = now_ms();
+  intro_sort_double(e, BENCH_SORT_LARGE, NULL);
+  report("qsort vs intro_sort_double, 2M random", old_ms, now_ms() - t);
+  ok &= check(memcmp(d, e, BENCH_SORT_LARGE * sizeof(double)) == 0,
+              "intro_sort_double");
+
+  free(input);
+  free(d);
+  free(e);
+  return ok;
+}
+
+/*
+ * lookup: the searches of user-024 against the old recursive
+ * 'binarysearch', with random keys into a table larger than the cache.
+ */
+
+static int old_binarysearch(int key, int *arr, int p1, int p2) {
+  if (p1 > p2) {
+    return -1;
+  }
+  int mid = (p1 + p2) / 2;
+  if (key == arr[mid]) {
+    return mid;
+  }
+  if (key < arr[mid]) {
+    return old_binarysearch(key, arr, p1, mid - 1);
+  } else {
+    return old_binarysearch(key, arr, mid + 1, p2);
+  }
+}
+
+/* A sorted table of distinct even IDs and keys, half of which exist */
+static bool bench_table(int **table, int **keys) {
+  *table = malloc(BENCH_TABLE_SIZE * sizeof(int));
+  *keys = malloc(BENCH_LOOKUPS * sizeof(int));
+  if (*table == NULL || *keys == NULL) {
+    free(*table);
+    free(*keys);
+    return false;
+  }
+  for (int i = 0; i < BENCH_TABLE_SIZE; ++i) {
+    (*table)[i] = 2 * i;
+  }
+  for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+    (*keys)[i] = (int)(bench_rand() % (2u * BENCH_TABLE_SIZE));
+  }
+  return true;
+}
+
+/* Checks lower bounds: every key which isn't in the table is odd, so
+   its first greater element is at key / 2 + 1, else it is at key / 2 */
+static bool bounds_match(const size_t *got, const int *keys) {
+  bool same = true;
+  for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+    same &= got[i] == (size_t)(keys[i] + 1) / 2;
+  }
+  return same;
+}
+
+static bool bench_lookup(void) {
+  int *table, *keys;
+  size_t *got = malloc(BENCH_LOOKUPS * sizeof(size_t));
+  eytzinger_index ix;
+  if (got == NULL || !bench_table(&table, &keys)) {
+    free(got);
+    return false;
+  }
+  printf("  %d random keys, table of %d ints (%d MB)\n", BENCH_LOOKUPS,
+         BENCH_TABLE_SIZE, (int)(BENCH_TABLE_SIZE * sizeof(int) >> 20));
+
+  double t = now_ms();
+  long old_hits = 0;
+  for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+    old_hits += old_binarysearch(keys[i], table, 0, BENCH_TABLE_SIZE - 1) >= 0;
+  }
+  double old_ms = now_ms() - t;
+
+  t = now_ms();
+  long new_hits = 0;
+  bool ok = true;
+  for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+    new_hits += findInSortedArray(keys[i], table, BENCH_TABLE_SIZE) >= 0;
+  }
+  report("findInSortedArray", old_ms, now_ms() - t);
+  ok &= check(old_hits == new_hits, "findInSortedArray");
+
+  t = now_ms();
+  for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+    got[i] = lower_bound_int(table, BENCH_TABLE_SIZE, keys[i]);
+  }
+  report("lower_bound_int", old_ms, now_ms() - t);
+  ok &= check(bounds_match(got, keys), "lower_bound_int");
+
+  if (eytzinger_build(&ix, table, BENCH_TABLE_SIZE) == 0) {
+    t = now_ms();
+    for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+      got[i] = eytzinger_lower_bound(&ix, keys[i]);
+    }
+    report("eytzinger_lower_bound", old_ms, now_ms() - t);
+    ok &= check(bounds_match(got, keys), "eytzinger_lower_bound");
+    memset(got, 0, BENCH_LOOKUPS * sizeof(size_t));
+    t = now_ms();
+    eytzinger_lower_bound_batch(&ix, keys, BENCH_LOOKUPS, got);
+    report("eytzinger_lower_bound_batch", old_ms, now_ms() - t);
+    ok &= check(bounds_match(got, keys), "eytzinger_lower_bound_batch");
+    eytzinger_free(&ix);
+  }
+
+  free(table);
+  free(keys);
+  free(got);
+  return ok;
+}
+
+/*
+ * batch: the batched lookups of user-025 against a loop over
+ * 'findInSortedArray', on the same table and keys as 'lookup'.
+ */
+
+static bool bench_batch(void) {
+  int *table, *keys;
+  size_t *got = malloc(BENCH_LOOKUPS * sizeof(size_t));
+  ptrdiff_t *rows = malloc(BENCH_LOOKUPS * sizeof(ptrdiff_t));
+  if (got == NULL || rows == NULL || !bench_table(&table, &keys)) {
+    free(got);
+    free(rows);
+    return false;
+  }
+  printf("  %d random keys, table of %d ints\n", BENCH_LOOKUPS, BENCH_TABLE_SIZE);
+
+  double t = now_ms();
+  long old_hits = 0;
+  bool ok = true;
+  for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+    int row = findInSortedArray(keys[i], table, BENCH_TABLE_SIZE);
+    old_hits += row >= 0;
+    ok &= row == (keys[i] % 2 == 0 ? keys[i] / 2 : -1);
+  }
+  double old_ms = now_ms() - t;
+
+  t = now_ms();
+  size_t new_hits = find_in_sorted_array_batch(table, BENCH_TABLE_SIZE, keys,
+                                               BENCH_LOOKUPS, rows);
+  report("find_in_sorted_array_batch", old_ms, now_ms() - t);
+  for (int i = 0; i < BENCH_LOOKUPS; ++i) {
+    ok &= rows[i] == (keys[i] % 2 == 0 ? keys[i] / 2 : -1);
+  }
+  ok = check(ok && new_hits == (size_t)old_hits, "find_in_sorted_array_batch");
+
+  t = now_ms();
+  lower_bound_int_batch(table, BENCH_TABLE_SIZE, keys, BENCH_LOOKUPS, got);
+  report("lower_bound_int_batch", old_ms, now_ms() - t);
+  ok &= check(bounds_match(got, keys), "lower_bound_int_batch");
+
+  free(table);
+  free(keys);
+  free(got);
+  free(rows);
+  return ok;
+}
+
+static const bench_entry benches[] = {
+  { "uptime", bench_uptime },
+  { "search", bench_search },
+  { "case", bench_case },
+  { "sort", bench_sort },
+  { "lookup", bench_lookup },
+  { "batch", bench_batch },
+};
+
+int main(int argc, char *argv[]) {
+  size_t n_benches = sizeof(benches) / sizeof(benches[0]);
+  bool ok = true;
+  for (size_t b = 0; b < n_benches; ++b) {
+    bool selected = argc < 2;
+    for (int a = 1; a < argc; ++a) {
+      selected |= strcmp(argv[a], benches[b].name) == 0;
+    }
+    if (selected) {
+      printf("%s\n", benches[b].name);
+      ok &= benches[b].run();
+    }
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+} /* End of bench.c */
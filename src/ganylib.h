@@ -15,6 +15,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
  * Copyright: June 2025, Georg Pohl, 70174 Stuttgart
@@ -45,10 +47,129 @@ char *get_date_time(bool both_formats);
  * @return *char
  * @details Makes a 'sr <hostname>' request and returns
  * the info string for this router for further processing.
- * Returns NULL if no entry is found.
+ * Returns NULL if no entry is found. 'sr' is run without a
+ * shell; hostnames starting with '-' are never looked up.
  */
 char *find_hostname_entry(char *hostname);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: find_hostname_entries
+ * Usage: found = find_hostname_entries(hosts, n, entries)
+ * -------------------------------------------------------
+ * @brief Returns the info strings for many hostnames at once
+ * @param const char **hosts Hostnames to look up
+ * @param size_t n Number of hostnames
+ * @param char **entries Array of 'n' results
+ * @return int Number of hosts found, -1 on error
+ * @details Like 'find_hostname_entry', but all hosts which
+ * are not cached yet are resolved with as few 'sr' requests
+ * as possible and the output is scanned only once. entries[i]
+ * is the info string for hosts[i] or NULL, if the host is
+ * unknown. 'sr' has to accept many hostnames in one call
+ * and print the entries of all of them. Even on error,
+ * every non-NULL entry has to be freed by the caller.
+ */
+int find_hostname_entries(const char **hosts, size_t n, char **entries);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: inventory_cache_set_ttl
+ * Usage: inventory_cache_set_ttl(600)
+ * -----------------------------------
+ * @brief Sets the lifetime of cached inventory entries
+ * @param unsigned int seconds
+ * @return void
+ * @details Answers of 'sr <hostname>' are cached by
+ * 'find_hostname_entry', so 'is_cisco_router', 'is_asr9k'
+ * and 'is_9001' share one request per host. An entry is
+ * refetched after 'seconds' (default: 300). A TTL of 0
+ * empties and disables the cache. The cache is not
+ * thread-safe.
+ */
+void inventory_cache_set_ttl(unsigned int seconds);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: inventory_cache_invalidate
+ * Usage: inventory_cache_invalidate("router1")
+ * --------------------------------------------
+ * @brief Drops cached inventory entries
+ * @param const char *hostname
+ * @return void
+ * @details Removes the cached entry of 'hostname' (case
+ * doesn't matter), so that the next lookup makes a new
+ * 'sr' request. If 'hostname' is NULL, all entries are
+ * dropped.
+ */
+void inventory_cache_invalidate(const char *hostname);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: inventory_cache_free
+ * Usage: inventory_cache_free()
+ * -----------------------------
+ * @brief Releases all memory held by the inventory cache
+ * @return void
+ * @details The cache can be used again afterwards.
+ */
+void inventory_cache_free(void);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: device_class
+ * ------------------
+ * Attributes of a device from its inventory entry, packed into one
+ * byte, so that classifications can be stored in arrays and filtered
+ * with a mask.
+ */
+enum {
+  DEVICE_KNOWN   = 1 << 0,  /*!< Host has an inventory entry */
+  DEVICE_CISCO   = 1 << 1,  /*!< Vendor is Cisco */
+  DEVICE_ASR9K   = 1 << 2,  /*!< Chassis family ASR9K */
+  DEVICE_ASR9001 = 1 << 3,  /*!< Model ASR9001 (implies DEVICE_ASR9K) */
+  DEVICE_C8000   = 1 << 4   /*!< Cisco C8000 (model "C8..." or "8000") */
+};
+typedef unsigned char device_class;
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: classify_device
+ * Usage: device_class cls = classify_device(hostname)
+ * ---------------------------------------------------
+ * @brief Classifies a device by its inventory entry
+ * @param const char *hostname
+ * @return device_class
+ * @details Fetches the inventory entry once and returns all
+ * DEVICE_* attributes found in it. Returns 0 if the host
+ * has no entry.
+ */
+device_class classify_device(const char *hostname);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: classify_devices
+ * Usage: found = classify_devices(hosts, n, classes)
+ * --------------------------------------------------
+ * @brief Classifies many devices at once
+ * @param const char **hosts
+ * @param size_t n
+ * @param device_class *classes Array of 'n' results
+ * @return int Number of hosts found, -1 on error
+ * @details Uses 'find_hostname_entries' to fetch all entries
+ * with as few 'sr' requests as possible and stores the class
+ * of hosts[i] in classes[i]. On error 'classes' is left
+ * unchanged.
+ */
+int classify_devices(const char **hosts, size_t n, device_class *classes);
+
 /**
  * Copyright: Februar 2025, Georg Pohl, 70174 Stuttgart
  *
@@ -102,10 +223,74 @@ bool is_9001(char *hostname);
  * @return bool
  * @details This function checks if a device is reachable by pinging
  * it once. It returns true if the device is reachable, otherwise
- * false.
+ * false. Like 'ping -c 1' it waits up to 10 s for the answer. The
+ * echo request is sent from this process ('probe_hosts' in probe.h).
+ * Where ICMP sockets aren't permitted, a TCP connect to port 22 is
+ * made instead; an answer on it (even a refusal) counts as
+ * reachable, while a timeout is confirmed by running 'ping', so a
+ * host which drops port 22 is still found. 'ping' is also run if no
+ * socket can be opened. Without ICMP a host answering neither way
+ * takes up to 20 s.
  */
 bool device_is_reachable(char *hostname);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: ping_host
+ * Usage: ping_host(hostname, 1000)
+ * --------------------------------
+ * @brief Pings a device once
+ * @param const char *hostname
+ * @param unsigned int timeout_ms Timeout, 0 for ping's default
+ * @return bool
+ * @details Runs 'ping -c 1' without a shell and returns true
+ * if the device answered. The macOS and FreeBSD ping take the
+ * timeout in milliseconds, elsewhere it is rounded up to whole
+ * seconds. This is
+ * the fallback probe of 'sweep_reachability'.
+ */
+bool ping_host(const char *hostname, unsigned int timeout_ms);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: reachability_probe
+ * ------------------------
+ * Checks one host, returns true if it is reachable within
+ * 'timeout_ms'. Must be callable from several threads at once.
+ */
+typedef bool (*reachability_probe)(const char *hostname, unsigned int timeout_ms);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: sweep_reachability
+ * Usage: up = sweep_reachability(hosts, n, reachable, 128, 1000, NULL)
+ * --------------------------------------------------------------------
+ * @brief Checks the reachability of many devices in parallel
+ * @param const char **hosts Hosts to check
+ * @param size_t n Number of hosts
+ * @param bool *reachable Array of 'n' results
+ * @param unsigned int workers Number of threads, 0 for the default (64)
+ * @param unsigned int timeout_ms Timeout per host
+ * @param reachability_probe probe Probe to use, NULL for the
+ * built-in one
+ * @return int Number of reachable hosts, -1 on error
+ * @details reachable[i] is the result for hosts[i]. A NULL host is
+ * reported as unreachable. With the built-in probe all hosts are
+ * probed from one thread with 'probe_hosts' (probe.h), by ICMP echo
+ * or, where ICMP sockets aren't permitted, a TCP connect to port 22.
+ * Hosts that can't be probed that way, and hosts whose TCP connect
+ * timed out (they may drop the port but answer a ping), are pinged
+ * by 'workers' threads with 'ping_host', so the result matches the
+ * 'ping' command. A custom probe is run by a bounded pool of
+ * 'workers' threads; pass 'probe_host' to accept the TCP result.
+ */
+int sweep_reachability(const char **hosts, size_t n, bool *reachable,
+                       unsigned int workers, unsigned int timeout_ms,
+                       reachability_probe probe);
+
 /**
   * Copyright: Februar 2024, Georg Pohl, 70174 Stuttgart
   *
@@ -116,29 +301,243 @@ bool device_is_reachable(char *hostname);
   * @param line of 'show version' output
   * @return int of the uptime in days
   * @details This function extracts the uptime of a router from the
-  * output of 'show version' and returns it in days.
+  * output of 'show version' and returns it in days. The line is
+  * not modified.
   */
 
 int extract_router_uptime(char* line);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: uptime_parser
+ * -------------------
+ * State of a streaming uptime parser. The fields are private, apart
+ * from the units found so far (valid after 'uptime_parser_finish').
+ */
+typedef struct {
+  int state;
+  bool keyword;         /*!< Look for "uptime is" first */
+  bool in_number;
+  long number;
+  long last_number;
+  char word[8];
+  size_t word_len;
+  long years, weeks, days, hours, minutes;
+} uptime_parser;
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: uptime_parser_init
+ * Usage: uptime_parser_init(&parser, true)
+ * ----------------------------------------
+ * @brief Prepares an uptime parser
+ * @param uptime_parser *p
+ * @param bool find_keyword
+ * @return void
+ * @details If 'find_keyword' is true, the input is a whole
+ * 'show version' output: everything is skipped up to "uptime
+ * is", and the end of that line ends the parsing. Otherwise
+ * the input is the uptime text itself.
+ */
+void uptime_parser_init(uptime_parser *p, bool find_keyword);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: uptime_parser_feed
+ * Usage: uptime_parser_feed(&parser, chunk, len)
+ * ----------------------------------------------
+ * @brief Parses the next chunk of input
+ * @param uptime_parser *p
+ * @param const char *data
+ * @param size_t len
+ * @return size_t Number of bytes consumed
+ * @details Chunks may be split anywhere, even inside a word.
+ * Years, weeks, days, hours and minutes are recognized (singular
+ * or plural, any case, also glued to the number as in "5days").
+ * The input is not modified and nothing is allocated, so one
+ * parser per thread can run concurrently. Fewer than 'len' bytes
+ * are consumed once the uptime line has ended.
+ */
+size_t uptime_parser_feed(uptime_parser *p, const char *data, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: uptime_parser_finish
+ * Usage: uptime_parser_finish(&parser)
+ * ------------------------------------
+ * @brief Ends the input, a pending last token is evaluated
+ * @param uptime_parser *p
+ * @return void
+ */
+void uptime_parser_finish(uptime_parser *p);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: uptime_parser_minutes
+ * Usage: long minutes = uptime_parser_minutes(&parser)
+ * ----------------------------------------------------
+ * @brief Returns the parsed uptime in minutes
+ * @param const uptime_parser *p
+ * @return long
+ * @details A year counts 365 days.
+ */
+long uptime_parser_minutes(const uptime_parser *p);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: parse_uptime_minutes
+ * Usage: long minutes = parse_uptime_minutes(text, len, true)
+ * -----------------------------------------------------------
+ * @brief Parses a complete uptime span in one call
+ * @param const char *text
+ * @param size_t len
+ * @param bool find_keyword See 'uptime_parser_init'
+ * @return long Uptime in minutes
+ */
+long parse_uptime_minutes(const char *text, size_t len, bool find_keyword);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: uptime_record, uptime_dump
+ * --------------------------------
+ * One record per "uptime is" line of a dump file. The hostname
+ * points into the mapped file and is n o t NUL-terminated; it stays
+ * valid until the dump is freed.
+ */
+typedef struct {
+  const char *hostname;
+  size_t hostname_len;
+  long uptime_minutes;
+} uptime_record;
+
+typedef struct {
+  uptime_record *records;
+  size_t n;
+  void *map;
+  size_t map_len;
+} uptime_dump;
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: extract_uptimes_from_file
+ * Usage: n = extract_uptimes_from_file("versions.log", 0, &dump)
+ * --------------------------------------------------------------
+ * @brief Extracts all router uptimes from a 'show version' dump
+ * @param const char *fn Dump file
+ * @param unsigned int threads Number of threads, 0 for one per CPU
+ * @param uptime_dump *dump Receives the records
+ * @return int Number of records, -1 on error
+ * @details The file is memory-mapped and split into newline
+ * aligned chunks, which are scanned in parallel for lines like
+ * "router1 uptime is 1 year, 2 weeks, 3 hours". The words in
+ * front of "uptime is" become the hostname. Records are in file
+ * order. Release them with 'uptime_dump_free'.
+ */
+int extract_uptimes_from_file(const char *fn, unsigned int threads, uptime_dump *dump);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: uptime_dump_free
+ * Usage: uptime_dump_free(&dump)
+ * ------------------------------
+ * @brief Releases the records and the mapping of a dump
+ * @param uptime_dump *dump
+ * @return void
+ */
+void uptime_dump_free(uptime_dump *dump);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: sort_uptime_records, count_uptimes_below
+ * Usage: sort_uptime_records(dump.records, dump.n)
+ * ------------------------------------------------
+ * @brief Sorts uptime records by uptime, shortest first
+ * @param uptime_record *records
+ * @param size_t n
+ * @return void
+ * @details Not stable. 'count_uptimes_below' returns the number of
+ * records of a sorted array with an uptime below 'minutes', e.g. the
+ * routers rebooted within the last day for 24 * 60.
+ */
+void sort_uptime_records(uptime_record *records, size_t n);
+size_t count_uptimes_below(const uptime_record *records, size_t n, long minutes);
+
 /**
  * Copyright: November 2024, Georg Pohl, 70174 Stuttgart
  *
  * @brief Sorts an array of integers using the counting sort algorithm.
  *
  * @details This function sorts an array of integers in non-decreasing
- * order using the counting sort algorithm. It first finds the maximum
- * value in the array to determine the range of the counts array. It
- * then counts the occurrences of each integer in the input array and
- * uses these counts to determine the starting indices of each integer
- * in the sorted array. Finally, it constructs the sorted array and
- * copies it back to the input array.
+ * order using the counting sort algorithm. It first finds the minimum
+ * and maximum value in the array to determine the range of the counts
+ * array. It then counts the occurrences of each integer in the input
+ * array and writes every value back as often as it was counted. Any
+ * int values are allowed, but the memory needed grows with the range
+ * (max - min); for wide ranges use 'radix_sort' or 'integer_sort'.
  *
  * @param array Pointer to the array of integers to be sorted.
  * @param size The number of elements in the array.
+ * @note Exits the program if the counts can't be allocated; use
+ * 'counting_sort_checked' to handle that.
  */
 void counting_sort(int *array, int size);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: counting_sort_checked
+ * Usage: if (counting_sort_checked(ifindex, n) != 0) ...
+ * ------------------------------------------------------
+ * @brief 'counting_sort' which reports errors instead of exiting
+ * @param int *array
+ * @param size_t n
+ * @return int 0, -1 if the counts can't be allocated (array unchanged)
+ */
+int counting_sort_checked(int *array, size_t n);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: radix_sort
+ * Usage: radix_sort(ifindex, n, NULL)
+ * -----------------------------------
+ * @brief Sorts ints in linear time (LSD radix sort, 11 bit digits)
+ * @param int *array
+ * @param size_t n
+ * @param int *scratch Buffer of 'n' ints, NULL to allocate one
+ * @return int 0, -1 if the memory can't be allocated (array unchanged)
+ * @details Stable, works for the full int range and needs at most
+ * three passes over the data, independent of the values. Passing a
+ * scratch buffer avoids the allocation when sorting repeatedly.
+ */
+int radix_sort(int *array, size_t n, int *scratch);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: integer_sort
+ * Usage: integer_sort(counters, n)
+ * --------------------------------
+ * @brief Sorts ints with counting or radix sort, whatever is faster
+ * @param int *array
+ * @param size_t n
+ * @return int 0, -1 if the memory can't be allocated (array unchanged)
+ * @details Looks at the range of the values first: narrow ranges
+ * (up to half the number of values) are counted, everything else is
+ * radix sorted.
+ */
+int integer_sort(int *array, size_t n);
+
 /**
  * Copyright: November 2023, Georg Pohl, 70174 Stuttgart
  *
@@ -152,11 +551,33 @@ void counting_sort(int *array, int size);
  * @exception Exceptions
  * 	      
  * The funktion returns the index where the pattern is found in the
- * original string 'a', otherwise if not found it returns -1.
+ * original string 'a', otherwise if not found it returns -1. If one
+ * of the strings is NULL, it returns -2.
  *
  */
 int search_pattern_in_string(char *a, char *b);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: search_pattern_in_buffer
+ * Usage: search_pattern_in_buffer(buf, buf_len, pat, pat_len)
+ * -----------------------------------------------------------
+ * @brief Searches a pattern in a buffer of known length
+ * @param const char *source Buffer to search in (no NUL needed)
+ * @param size_t source_length
+ * @param const char *pattern Search pattern
+ * @param size_t pattern_length
+ * @return ptrdiff_t Index of the first match, -1 if not found,
+ * -2 if a pointer is NULL
+ * @details Like 'search_pattern_in_string', but with size_t
+ * lengths, so buffers beyond 2 GB can be searched. Short
+ * patterns are found with a vectorized first/last byte filter
+ * (AVX2 or SSE2), long ones with Boyer-Moore-Horspool.
+ */
+ptrdiff_t search_pattern_in_buffer(const char *source, size_t source_length,
+                                   const char *pattern, size_t pattern_length);
+
 /**
  * Copyright: November 2023, Georg Pohl, 70174 Stuttgart
  *
@@ -293,6 +714,178 @@ void erase_from_to(char *a, int from, int to);
  */
 void text_part_from_to(char *a, char *b, int from, int to);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: text_span
+ * ---------------
+ * A piece of text given by pointer and length; it is n o t
+ * NUL-terminated and points into memory owned by someone else.
+ */
+typedef struct {
+  const char *ptr;
+  size_t len;
+} text_span;
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: str_buf
+ * -------------
+ * A string in a buffer of fixed capacity which knows its length.
+ * 'ptr' is always NUL-terminated, so it can be passed on as a C
+ * string; 'cap' counts the NUL, so at most cap - 1 characters fit.
+ *
+ * The str_buf functions never write beyond 'cap': if a result
+ * doesn't fit, they return STR_BUF_ERROR and leave the string as it
+ * was. Texts passed in are given by pointer and length, they need no
+ * NUL. Positions and lengths are clamped like in 'erase_from_length'
+ * and friends; a start behind the end is an error.
+ */
+typedef struct {
+  char *ptr;
+  size_t len;
+  size_t cap;
+} str_buf;
+
+#define STR_BUF_ERROR -1
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: str_buf_wrap
+ * Usage: char line[256] = "..."; str_buf sb = str_buf_wrap(line, sizeof(line))
+ * -------------------------------------------------------------------------
+ * @brief Makes a str_buf from a buffer holding a C string
+ * @param char *storage
+ * @param size_t cap Size of 'storage' in bytes
+ * @return str_buf
+ * @details The length is measured once here. A string without
+ * NUL within 'cap' is cut to cap - 1 characters.
+ */
+str_buf str_buf_wrap(char *storage, size_t cap);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: str_buf_assign, str_buf_append
+ * Usage: str_buf_assign(&sb, text, len)
+ * -------------------------------------
+ * @brief Sets the string to / appends 'len' bytes of 'text'
+ * @return int 0 or STR_BUF_ERROR
+ * @details 'text' may point into the buffer itself (e.g. a
+ * slice of it).
+ */
+int str_buf_assign(str_buf *sb, const char *text, size_t len);
+int str_buf_append(str_buf *sb, const char *text, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: str_buf_insert
+ * Usage: str_buf_insert(&sb, pos, text, len)
+ * ------------------------------------------
+ * @brief Inserts 'len' bytes of 'text' at index 'pos'
+ * @return int 0 or STR_BUF_ERROR
+ * @details Bounds-checked counterpart of 'insert_at_position'.
+ * 'text' may point into the buffer itself.
+ */
+int str_buf_insert(str_buf *sb, size_t pos, const char *text, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: str_buf_erase
+ * Usage: str_buf_erase(&sb, from, len)
+ * ------------------------------------
+ * @brief Erases 'len' characters from index 'from' on
+ * @return int 0 or STR_BUF_ERROR
+ */
+int str_buf_erase(str_buf *sb, size_t from, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: str_buf_replace
+ * Usage: str_buf_replace(&sb, from, len, text, text_len)
+ * ------------------------------------------------------
+ * @brief Replaces 'len' characters at 'from' by 'text'
+ * @return int 0 or STR_BUF_ERROR
+ * @details One memmove of the tail instead of an erase and an
+ * insert like 'replace_from_length'. 'text' may point into the
+ * buffer itself, also into the replaced range.
+ */
+int str_buf_replace(str_buf *sb, size_t from, size_t len,
+                    const char *text, size_t text_len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: str_buf_slice
+ * Usage: text_span part = str_buf_slice(&sb, from, len)
+ * -----------------------------------------------------
+ * @brief Returns a part of the string as a span, without copying
+ * @return text_span Empty if 'from' is behind the end
+ * @details Counterpart of 'text_part_from_length'; use
+ * 'str_buf_assign' to copy the span into another str_buf.
+ */
+text_span str_buf_slice(const str_buf *sb, size_t from, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: str_buf_find
+ * Usage: ptrdiff_t index = str_buf_find(&sb, 0, "vrf", 3)
+ * -------------------------------------------------------
+ * @brief Searches a pattern from index 'from' on
+ * @return ptrdiff_t Index of the match or -1
+ */
+ptrdiff_t str_buf_find(const str_buf *sb, size_t from, const char *pattern,
+                       size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: replace_all
+ * Usage: char *out = replace_all(config, len, "Gi0/0", "Te0/0", &out_len)
+ * -----------------------------------------------------------------------
+ * @brief Replaces every occurrence of a pattern
+ * @param const char *text Text of 'len' bytes (no NUL needed)
+ * @param size_t len
+ * @param const char *from Pattern, must not be empty
+ * @param const char *to Replacement
+ * @param size_t *out_len Receives the length of the result, may be NULL
+ * @return char* New NUL-terminated text, to be freed by the caller;
+ * NULL if 'from' is empty or memory is exhausted
+ * @details Occurrences are replaced from left to right and don't
+ * overlap. The text is scanned once and the result is built in
+ * one pass, so the cost is linear in input plus output size.
+ */
+char *replace_all(const char *text, size_t len, const char *from, const char *to,
+                  size_t *out_len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: replace_many
+ * Usage: char *out = replace_many(config, len, from, to, n, &out_len)
+ * -------------------------------------------------------------------
+ * @brief Applies many substitutions (from[i] -> to[i]) at once
+ * @param const char *text
+ * @param size_t len
+ * @param const char **from Patterns, empty (or NULL) ones are ignored
+ * @param const char **to Replacements, NULL is taken as "" (deletes)
+ * @param size_t n Number of substitutions
+ * @param size_t *out_len Receives the length of the result, may be NULL
+ * @return char* New NUL-terminated text, to be freed by the caller
+ * @details All patterns are searched in a single pass over the
+ * text. Where matches overlap, the leftmost wins, and of those
+ * starting at the same position the longest (the first one, if a
+ * pattern is listed twice). Replacements are not searched again.
+ */
+char *replace_many(const char *text, size_t len, const char **from,
+                   const char **to, size_t n, size_t *out_len);
+
 /**
  * Copyright: October 2023, Georg Pohl, 70174 Stuttgart
  *
@@ -306,10 +899,94 @@ void text_part_from_to(char *a, char *b, int from, int to);
  * @return char *str
  *
  * Examines a line for a pattern and then returns the term at the
- * given position.
+ * given position. The line is not modified; the term is copied to
+ * a thread-local buffer of 1024 bytes, which must not be freed.
+ * It is valid until the same thread calls again or exits. NULL if
+ * not found; NULL with errno == ERANGE if the term is 1024 bytes
+ * or longer ('unspecific_search_span' has no such limit).
  */
 char* unspecific_search(const char* line, const char* pattern, int position);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: unspecific_search_span
+ * Usage: unspecific_search_span(line, len, pattern, position, &term)
+ * ------------------------------------------------------------------
+ * @brief Reentrant 'unspecific_search' over a span
+ * @param const char *line
+ * @param size_t len
+ * @param const char *pattern
+ * @param int position
+ * @param text_span *token Receives the term
+ * @return bool true if found
+ * @details The term points into 'line', which is not modified.
+ */
+bool unspecific_search_span(const char *line, size_t len, const char *pattern,
+                            int position, text_span *token);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: delimiter_set, tokenizer
+ * ------------------------------
+ * A set of delimiter bytes as a 256-bit table, and the state of a
+ * tokenizer over a const text. Both may live on the stack; nothing
+ * is allocated.
+ */
+typedef struct {
+  uint64_t bits[4];
+} delimiter_set;
+
+typedef struct {
+  const char *pos;
+  const char *end;
+  const delimiter_set *delims;
+} tokenizer;
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: delimiter_set_init
+ * Usage: delimiter_set_init(&set, " ,\t")
+ * ---------------------------------------
+ * @brief Builds a delimiter set from the bytes of a string
+ * @param delimiter_set *set
+ * @param const char *delims
+ * @return void
+ */
+void delimiter_set_init(delimiter_set *set, const char *delims);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: tokenizer_init, tokenizer_next
+ * Usage: while (tokenizer_next(&t, &token)) { ... }
+ * -------------------------------------------------
+ * @brief Reentrant replacement for strtok()
+ * @param tokenizer *t
+ * @param text_span *token Receives the next token
+ * @return bool false when there are no more tokens
+ * @details Tokens are maximal runs of non-delimiter bytes;
+ * empty tokens are skipped, like with strtok(). The text is
+ * not modified and need not be NUL-terminated.
+ */
+void tokenizer_init(tokenizer *t, const char *text, size_t len,
+                    const delimiter_set *delims);
+bool tokenizer_next(tokenizer *t, text_span *token);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: nth_token
+ * Usage: nth_token(line, len, &delims, 3, &token)
+ * -----------------------------------------------
+ * @brief Finds the n-th token (1-based) of a text
+ * @return bool false if there are fewer than 'n' tokens
+ */
+bool nth_token(const char *text, size_t len, const delimiter_set *delims,
+               size_t n, text_span *token);
+
 /**
  * Copyright: May 2021, Georg Pohl, 70174 Stuttgart
  *
@@ -340,6 +1017,153 @@ void make_string_lwrcase(char *str);
  */
 void make_string_uprcase(char *str);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: ascii_lowercase, ascii_uppercase
+ * Usage: ascii_lowercase(line, len)
+ * ---------------------------------
+ * @brief Converts 'len' bytes to lower-/uppercase, inline
+ * @param char *str
+ * @param size_t len
+ * @return void
+ *
+ * Only the ASCII letters A-Z/a-z are changed, all other bytes
+ * (including NUL and UTF-8 sequences) are left alone. 16 or 32
+ * bytes are converted per step with SSE2 or AVX2 (chosen at
+ * runtime).
+ */
+void ascii_lowercase(char *str, size_t len);
+void ascii_uppercase(char *str, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: ascii_lowercase_copy, ascii_uppercase_copy
+ * Usage: ascii_lowercase_copy(dst, src, len)
+ * ------------------------------------------
+ * @brief Like 'ascii_lowercase', but writes into 'dst'
+ * @param char *dst At least 'len' bytes, no NUL is appended
+ * @param const char *src
+ * @param size_t len
+ * @return void
+ */
+void ascii_lowercase_copy(char *dst, const char *src, size_t len);
+void ascii_uppercase_copy(char *dst, const char *src, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: ascii_equal_nocase
+ * Usage: if (ascii_equal_nocase(a, b, len)) ...
+ * ---------------------------------------------
+ * @brief Compares 'len' bytes, ignoring the case of ASCII letters
+ * @param const char *a
+ * @param const char *b
+ * @param size_t len
+ * @return bool
+ * @details Vectorized, no copies are made. NUL bytes are
+ * compared like any other byte, so check the lengths first.
+ */
+bool ascii_equal_nocase(const char *a, const char *b, size_t len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: ascii_prefix_nocase
+ * Usage: ascii_prefix_nocase(line, line_len, host, host_len)
+ * ----------------------------------------------------------
+ * @brief Checks if 'text' starts with 'prefix', ignoring case
+ * @return bool
+ */
+bool ascii_prefix_nocase(const char *text, size_t text_len,
+                         const char *prefix, size_t prefix_len);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: line_sink, line_callback
+ * ------------------------------
+ * A 'line_callback' is called by 'line_pipeline_run' for every line
+ * of the input. 'line' is the text without '\n' or "\r\n". The
+ * callback decides what goes to the output: nothing (the line is
+ * dropped), the line itself ('line_sink_keep') or any other text
+ * ('line_sink_write'). A return value other than 0 stops the
+ * callbacks; the rest of the input is then copied unchanged.
+ */
+typedef struct line_sink line_sink;
+typedef int (*line_callback)(text_span line, line_sink *out, void *ctx);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: line_pipeline_run
+ * Usage: lines = line_pipeline_run("hosts.txt", "hosts.txt", drop_lab_hosts, &ctx)
+ * --------------------------------------------------------------------------------
+ * @brief Streams a text file line by line through a callback
+ * @param const char *in_fn Input file
+ * @param const char *out_fn Output file, may be 'in_fn'; NULL if the
+ * callback only reads
+ * @param line_callback cb
+ * @param void *ctx Passed to 'cb'
+ * @return long Number of lines passed to 'cb', -1 on error
+ * @details Regular files are memory mapped, other inputs are read in
+ * large blocks; lines can have any length. The output is buffered,
+ * written to a temporary file and renamed onto 'out_fn' at the end
+ * (permissions taken from 'in_fn'), so on error 'out_fn' stays as
+ * it was.
+ */
+long line_pipeline_run(const char *in_fn, const char *out_fn,
+                       line_callback cb, void *ctx);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: line_pipeline_run_parallel
+ * Usage: lines = line_pipeline_run_parallel("flows.log", "flows.out", 0, mask_ips, &ctx)
+ * -------------------------------------------------------------------------------------
+ * @brief Like 'line_pipeline_run', but on several threads
+ * @param unsigned int threads Number of threads, 0 for one per CPU
+ * @return long Number of lines passed to 'cb', -1 on error
+ * @details The file is split into newline aligned chunks, which are
+ * processed concurrently; the output is written in file order and
+ * is the same as with 'line_pipeline_run'. 'cb' is called from
+ * several threads at once, so it must not change 'ctx' without
+ * synchronization. If 'cb' stops, lines behind the stopping one may
+ * have been passed to 'cb' as well; they are output unchanged and not
+ * counted. Inputs which are not regular files, files below 2 MiB
+ * and 'threads' == 1 take the serial path.
+ */
+long line_pipeline_run_parallel(const char *in_fn, const char *out_fn,
+                                unsigned int threads, line_callback cb, void *ctx);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: line_sink_write, line_sink_keep
+ * Usage: line_sink_write(out, line.ptr, line.len)
+ * -----------------------------------------------
+ * @brief Output of a 'line_callback'
+ * @return int 0, -1 if writing failed
+ * @details 'line_sink_write' appends any text (add the '\n' yourself),
+ * 'line_sink_keep' the current line with its original line ending.
+ * Without an output file both do nothing.
+ */
+int line_sink_write(line_sink *out, const char *text, size_t len);
+int line_sink_keep(line_sink *out);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: file_scan_set_threads
+ * Usage: file_scan_set_threads(0)
+ * -------------------------------
+ * @brief Threads used by 'unspecificSearch' and 'delete_entries_from_file'
+ * @param unsigned int threads 0 for one per CPU, default is 1 (serial)
+ * @return void
+ */
+void file_scan_set_threads(unsigned int threads);
+
 /**
  * Copyright: May 2021, Georg Pohl, 70174 Stuttgart
  *
@@ -352,7 +1176,7 @@ void make_string_uprcase(char *str);
  *
  * The function can be used to delete random entries from a given
  * file, line by line. Therefore the user has to enter the words/terms
- * to be deleted.  Input is converted to uppercase.  Then the original
+ * to be deleted.  Case is ignored when comparing.  Then the original
  * file is read line by line and every term that is n o t mentioned
  * from the user is written in a temporay file. At the end the
  * temp-file is renamed to the original filename, which contains only
@@ -360,6 +1184,45 @@ void make_string_uprcase(char *str);
  */
 void delete_entries_from_file(char *fn);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: remove_entries_from_file
+ * Usage: deleted = remove_entries_from_file(fn, entries, n, hits, 0)
+ * ------------------------------------------------------------------
+ * @brief Deletes all lines equal to one of the given entries
+ * @param const char *fn File to clean up
+ * @param const char **entries Entries to delete
+ * @param size_t n Number of entries
+ * @param size_t *hits Array of 'n' counters (or NULL); the number
+ * of deleted lines is added per entry
+ * @param unsigned int threads 0 for one per CPU, 1 for serial
+ * @return long Number of deleted lines, -1 on error
+ * @details Non-interactive counterpart of 'delete_entries_from_file'.
+ * A line is deleted if it equals an entry, ignoring case and the line
+ * ending. The entries are kept in a hash set, so thousands of entries
+ * cost no more per line than one. Lines may have any length. The
+ * result is written to a temporary file, which atomically replaces
+ * the original; on error the original is left untouched.
+ */
+long remove_entries_from_file(const char *fn, const char **entries, size_t n,
+                              size_t *hits, unsigned int threads);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: remove_entries_listed_in_file
+ * Usage: deleted = remove_entries_listed_in_file("hosts.txt", "decommissioned.txt", 0)
+ * ------------------------------------------------------------------------------------
+ * @brief Like 'remove_entries_from_file', entries are read from a file
+ * @param const char *fn File to clean up
+ * @param const char *list_fn One entry per line, empty lines are skipped
+ * @param unsigned int threads 0 for one per CPU, 1 for serial
+ * @return long Number of deleted lines, -1 on error
+ */
+long remove_entries_listed_in_file(const char *fn, const char *list_fn,
+                                   unsigned int threads);
+
 /**
  * Copyright: Eric S. Roberts
  *
@@ -375,8 +1238,8 @@ void delete_entries_from_file(char *fn);
  * Searches for the specified key in the array *arr, which must be
  * sorted in lexicographic (character code) order. If the key is
  * found, the function returns the index in the vector at which that
- * key appers. (If the key appears more than once in the array, any of
- * the matching indices may be returned). If the key does not exist in
+ * key appers. (If the key appears more than once in the array, the
+ * lowest matching index is returned). If the key does not exist in
  * the array, the function returns -1. This implementation is simply a
  * wrapper function; all of real work is done by the more general
  * binary search function.
@@ -391,10 +1254,120 @@ int findInSortedArray(int key, int *arr, int n);
  * --------------------------------------------------
  * @brief Searches for the specific key in the arrar *arr, looking only
  * at indices between p1 and p2, inclusive.  The function returns the
- * index of a matching element, or -1 if no match is found.
+ * index of a matching element, or -1 if no match is found. The search
+ * is iterative (see 'lower_bound_int') and safe for indices close to
+ * INT_MAX.
  */
 int binarysearch(int key, int *arr, int p1, int p2);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: lower_bound_int, upper_bound_int
+ * Usage: size_t first = lower_bound_int(ids, n, id);
+ * --------------------------------------------------
+ * @brief Branch-free search in a sorted array
+ * @param const int *arr Sorted ascending
+ * @param size_t n
+ * @param int key
+ * @return size_t Index of the first element not less than (greater
+ * than) 'key', 'n' if there is none
+ * @details [lower_bound_int, upper_bound_int) is the range of the
+ * elements equal to 'key'. The loop has a fixed trip count of about
+ * log2(n) and prefetches ahead, so there are no mispredicted branches
+ * and fewer stalls on arrays larger than the cache.
+ */
+size_t lower_bound_int(const int *arr, size_t n, int key);
+size_t upper_bound_int(const int *arr, size_t n, int key);
+
+/* Sorted keys in breadth-first (Eytzinger) order, see eytzinger_build */
+typedef struct {
+  int *keys;            /*!< Slots 1..n, 64-byte aligned */
+  size_t *ranks;        /*!< Per slot: index in the sorted array */
+  size_t n;
+  unsigned int depth;   /*!< No. of lockstep levels, floor(log2 n) */
+} eytzinger_index;
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: eytzinger_build, eytzinger_free
+ * Usage: if (eytzinger_build(&ix, ids, n) == 0) { ...; eytzinger_free(&ix); }
+ * ---------------------------------------------------------------------------
+ * @brief Builds a cache-friendly search index over a sorted array
+ * @param eytzinger_index *ix
+ * @param const int *sorted Sorted ascending, not needed afterwards
+ * @param size_t n
+ * @return int 0 on success, -1 if out of memory
+ * @details Stores the keys as a binary search tree laid out level by
+ * level, so the top levels of all searches share a few cache lines and
+ * the next levels can be prefetched. Meant for read-mostly tables that
+ * are searched far more often than they change; a change needs a new
+ * build (O(N)). Takes n * (sizeof(int) + sizeof(size_t)) bytes.
+ */
+int eytzinger_build(eytzinger_index *ix, const int *sorted, size_t n);
+void eytzinger_free(eytzinger_index *ix);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: eytzinger_lower_bound, eytzinger_find
+ * Usage: ptrdiff_t row = eytzinger_find(&ix, id);
+ * -----------------------------------------------
+ * @brief Searches an Eytzinger index
+ * @param const eytzinger_index *ix
+ * @param int key
+ * @return size_t (ptrdiff_t) Index in the sorted array the index was
+ * built from: of the first element not less than 'key' ('n' if none),
+ * or of an element equal to 'key' (-1 if none)
+ */
+size_t eytzinger_lower_bound(const eytzinger_index *ix, int key);
+ptrdiff_t eytzinger_find(const eytzinger_index *ix, int key);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: eytzinger_lower_bound_batch
+ * Usage: eytzinger_lower_bound_batch(&ix, ids, m, rows)
+ * -----------------------------------------------------
+ * @brief Looks up many keys at once
+ * @param const eytzinger_index *ix
+ * @param const int *keys
+ * @param size_t m No. of keys
+ * @param size_t *out Receives 'eytzinger_lower_bound' of every key
+ * @return void
+ * @details The searches run in groups of 16 which go down the tree in
+ * lockstep, so up to 16 cache misses are outstanding at a time instead
+ * of one. The keys need not be sorted.
+ */
+void eytzinger_lower_bound_batch(const eytzinger_index *ix, const int *keys,
+                                 size_t m, size_t *out);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: lower_bound_int_batch, find_in_sorted_array_batch
+ * Usage: hits = find_in_sorted_array_batch(ids, n, keys, m, rows);
+ * ----------------------------------------------------------------
+ * @brief Searches many keys in a sorted array in one call
+ * @param const int *arr Sorted ascending
+ * @param size_t n
+ * @param const int *keys
+ * @param size_t m No. of keys
+ * @param size_t *out Receives 'lower_bound_int' of every key
+ * (ptrdiff_t *out: the lowest index of the key, or -1 if missing)
+ * @return size_t No. of keys found (find_in_sorted_array_batch)
+ * @details Batch versions of 'lower_bound_int' and
+ * 'findInSortedArray' for joins against large tables: 32 searches at a
+ * time run interleaved, so their cache misses overlap instead of
+ * following one another. The keys need not be sorted. Unlike
+ * 'eytzinger_build' this needs no copy of the table.
+ */
+void lower_bound_int_batch(const int *arr, size_t n, const int *keys, size_t m,
+                           size_t *out);
+size_t find_in_sorted_array_batch(const int *arr, size_t n, const int *keys,
+                                  size_t m, ptrdiff_t *out);
+
 /**
  * Copyright: Eric S. Roberts
  *
@@ -463,6 +1436,46 @@ int bubble_sort(int *array, int n);
  */
 int selection_sort(int *array, int n);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: intro_sort, intro_sort_double
+ * Usage: intro_sort(samples, n, NULL)
+ * -----------------------------------
+ * @brief Sorts in O(N log N), also in the worst case
+ * @param int *array (double *array)
+ * @param size_t n
+ * @param size_t *swaps Receives the no. of exchanges, may be NULL
+ * @return void
+ * @details Introsort (quicksort with median-of-three pivots,
+ * branchless partitioning, insertion sort for short and heapsort for
+ * degenerated partitions). Not stable. Arrays with many equal values
+ * are sorted in linear time. 'intro_sort_double' puts NaNs at the
+ * end, in no particular order.
+ */
+void intro_sort(int *array, size_t n, size_t *swaps);
+void intro_sort_double(double *array, size_t n, size_t *swaps);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: parallel_sort, parallel_sort_double
+ * Usage: parallel_sort_double(samples, n, 0)
+ * ------------------------------------------
+ * @brief Sorts large arrays on several threads
+ * @param int *array (double *array)
+ * @param size_t n
+ * @param unsigned int threads 0 for one per CPU
+ * @return void
+ * @details Every thread sorts a part with 'intro_sort', then the
+ * parts are merged in parallel rounds. Needs a scratch buffer of the
+ * array's size; without memory for it, or below 64K elements per
+ * thread, the array is sorted on fewer threads or serially. The
+ * result is the same as with 'intro_sort' (NaNs at the end).
+ */
+void parallel_sort(int *array, size_t n, unsigned int threads);
+void parallel_sort_double(double *array, size_t n, unsigned int threads);
+
 /**
  * Copyright: May 2021, Georg Pohl, 70174 Stuttgart
  *
@@ -535,10 +1548,113 @@ void killNL(char *str);
  * This function opens a filestream from a given filename 'fn', reads
  * it line by line until it reaches the search pattern(s). From this
  * line the term found at position 'offset' is returned; where offset
- * 1 finds the first word, etc.
+ * 1 finds the first word, etc. The result is valid until the next
+ * call. The indexed file is kept open between calls and reloaded
+ * when it changes on disk; unspecificSearch(NULL, 0, "", "", "")
+ * releases it. Not thread-safe: the cached file and the result are
+ * shared by all callers. For many lookups in the same file, or from
+ * several threads, use 'file_search_open'.
  */
 char *unspecificSearch(char *fn, int offset, const char *p1, const char *p2, const char *p3);
 
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Type: file_search
+ * -----------------
+ * Handle of a file which is loaded once for many lookups.
+ */
+typedef struct file_search file_search;
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: file_search_open
+ * Usage: file_search *fs = file_search_open("inventory.txt")
+ * ----------------------------------------------------------
+ * @brief Loads a file for repeated searches
+ * @param const char *fn
+ * @return file_search* NULL if the file can't be read
+ * @details The file is memory-mapped and its lines are
+ * indexed. Changes to the file after opening are not seen.
+ * Release the handle with 'file_search_close'.
+ */
+file_search *file_search_open(const char *fn);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: file_search_close
+ * Usage: file_search_close(fs)
+ * ----------------------------
+ * @brief Releases a file search handle
+ * @param file_search *fs
+ * @return void
+ * @details All spans handed out by the handle become invalid.
+ */
+void file_search_close(file_search *fs);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: file_search_set_threads
+ * Usage: file_search_set_threads(fs, 0)
+ * -------------------------------------
+ * @brief Lets the queries of a handle run on several threads
+ * @param file_search *fs
+ * @param unsigned int threads 0 for one per CPU, default is 1
+ * @return void
+ * @details Only files of 2 MiB and more are searched in parallel;
+ * the results are the same as with one thread.
+ */
+void file_search_set_threads(file_search *fs, unsigned int threads);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: file_search_query
+ * Usage: found = file_search_query(fs, 4, "Copyright", "", "", &field)
+ * --------------------------------------------------------------------
+ * @brief Looks up a term in the indexed file
+ * @param const file_search *fs
+ * @param int offset Position of the term in the line, 1 is the first
+ * @param const char *p1, *p2, *p3 Patterns, "" for unused ones
+ * @param text_span *result Receives the term
+ * @return bool true if found
+ * @details Same lookup as 'unspecificSearch': the first line
+ * containing all three patterns and at least 'offset' terms
+ * (separated by blanks, commas or tabs) is taken. The result
+ * points into the file and stays valid until the handle is
+ * closed.
+ */
+bool file_search_query(const file_search *fs, int offset, const char *p1,
+                       const char *p2, const char *p3, text_span *result);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: file_search_query_dup
+ * Usage: char *term = file_search_query_dup(fs, 2, "hostname", "", "")
+ * --------------------------------------------------------------------
+ * @brief Like 'file_search_query', but returns an own copy
+ * @return char* Term to be freed by the caller, NULL if not found
+ */
+char *file_search_query_dup(const file_search *fs, int offset, const char *p1,
+                            const char *p2, const char *p3);
+
+/**
+ * Copyright: October 2026, Georg Pohl, 70174 Stuttgart
+ *
+ * Function: file_search_lines, file_search_line
+ * Usage: file_search_line(fs, n, &line)
+ * -------------------------------------
+ * @brief Number of lines and access to line 'n' (0-based)
+ * @details The line span excludes the line break.
+ * 'file_search_line' returns false if 'n' is out of range.
+ */
+size_t file_search_lines(const file_search *fs);
+bool file_search_line(const file_search *fs, size_t n, text_span *line);
+
 /**
  * Copyright: August 2020, Georg Pohl, 70174 Stuttgart,
  *
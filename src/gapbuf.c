@@ -0,0 +1,192 @@
+/** @file gapbuf.c
+ *  @brief Growable text buffer for many edits (gap buffer)
+ *
+ *  @author Georg Pohl
+ *
+ *  @bug no known bugs
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Layout: buf[0, gap_start) is the text before the gap,
+ *  buf[gap_end, cap) the text behind it. Moving the gap shifts only
+ *  the bytes between the old and the new position (one memmove).
+ *  When the gap is too small, the array grows by at least half of
+ *  its size, so inserts are amortized O(insert size).
+ *
+ *  New text may come from the buffer itself (e.g. a pointer from
+ *  gap_buffer_cstr). Moving the gap would shift it and growing would
+ *  free it, so such text is copied aside first.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gapbuf.h"
+
+/* CONSTANTS */
+
+#define GAP_BUFFER_MIN_GAP 64
+
+/* FUNCTIONS */
+
+static size_t gap_size(const gap_buffer *gb) {
+  return gb->gap_end - gb->gap_start;
+}
+
+/* Moves the gap, so that it starts at text position 'pos' */
+static void gap_move(gap_buffer *gb, size_t pos) {
+  if (pos < gb->gap_start) {
+    size_t n = gb->gap_start - pos;
+    memmove(gb->buf + gb->gap_end - n, gb->buf + pos, n);
+    gb->gap_start -= n;
+    gb->gap_end -= n;
+  } else if (pos > gb->gap_start) {
+    size_t n = pos - gb->gap_start;
+    memmove(gb->buf + gb->gap_start, gb->buf + gb->gap_end, n);
+    gb->gap_start += n;
+    gb->gap_end += n;
+  }
+}
+
+/* Makes the gap at least 'need' bytes large */
+static int gap_reserve(gap_buffer *gb, size_t need) {
+  if (gap_size(gb) >= need) {
+    return 0;
+  }
+  size_t len = gap_buffer_length(gb);
+  size_t cap = gb->cap + gb->cap / 2;
+  if (cap < len + need + GAP_BUFFER_MIN_GAP) {
+    cap = len + need + GAP_BUFFER_MIN_GAP;
+  }
+  char *buf = realloc(gb->buf, cap);
+  if (buf == NULL) {
+    return -1;
+  }
+  size_t tail = gb->cap - gb->gap_end;
+  memmove(buf + cap - tail, buf + gb->gap_end, tail);
+  gb->buf = buf;
+  gb->gap_end = cap - tail;
+  gb->cap = cap;
+  return 0;
+}
+
+/* Tells if 'text' points into the buffer's array */
+static bool gap_owns(const gap_buffer *gb, const char *text) {
+  uintptr_t p = (uintptr_t)text, base = (uintptr_t)gb->buf;
+  return gb->buf != NULL && p >= base && p < base + gb->cap;
+}
+
+int gap_buffer_init(gap_buffer *gb, const char *text, size_t len) {
+  gb->cap = len + GAP_BUFFER_MIN_GAP;
+  gb->buf = malloc(gb->cap);
+  if (gb->buf == NULL) {
+    gb->cap = 0;
+    gb->gap_start = gb->gap_end = 0;
+    return -1;
+  }
+  if (len > 0) {
+    memcpy(gb->buf, text, len);
+  }
+  gb->gap_start = len;
+  gb->gap_end = gb->cap;
+  return 0;
+}
+
+void gap_buffer_free(gap_buffer *gb) {
+  free(gb->buf);
+  gb->buf = NULL;
+  gb->cap = gb->gap_start = gb->gap_end = 0;
+}
+
+size_t gap_buffer_length(const gap_buffer *gb) {
+  return gb->cap - gap_size(gb);
+}
+
+int gap_buffer_insert(gap_buffer *gb, size_t pos, const char *text, size_t len) {
+  return gap_buffer_replace(gb, pos, 0, text, len);
+}
+
+int gap_buffer_erase(gap_buffer *gb, size_t pos, size_t len) {
+  size_t total = gap_buffer_length(gb);
+  if (pos > total || len > total - pos) {
+    return -1;
+  }
+  gap_move(gb, pos);
+  gb->gap_end += len;
+  return 0;
+}
+
+int gap_buffer_replace(gap_buffer *gb, size_t pos, size_t len,
+                       const char *text, size_t text_len) {
+  size_t total = gap_buffer_length(gb);
+  if (pos > total || len > total - pos) {
+    return -1;
+  }
+  if (text_len > 0 && gap_owns(gb, text)) {
+    char *copy = malloc(text_len);
+    if (copy == NULL) {
+      return -1;
+    }
+    memcpy(copy, text, text_len);
+    int rc = gap_buffer_replace(gb, pos, len, copy, text_len);
+    free(copy);
+    return rc;
+  }
+  if (text_len > len && gap_reserve(gb, text_len - len) != 0) {
+    return -1;
+  }
+  gap_move(gb, pos);
+  gb->gap_end += len;
+  memcpy(gb->buf + gb->gap_start, text, text_len);
+  gb->gap_start += text_len;
+  return 0;
+}
+
+size_t gap_buffer_extract(const gap_buffer *gb, size_t pos, size_t len, char *dst) {
+  size_t total = gap_buffer_length(gb);
+  if (pos >= total) {
+    return 0;
+  }
+  if (len > total - pos) {
+    len = total - pos;
+  }
+  size_t copied = 0;
+  if (pos < gb->gap_start) {
+    size_t n = gb->gap_start - pos < len ? gb->gap_start - pos : len;
+    memcpy(dst, gb->buf + pos, n);
+    copied = n;
+    pos += n;
+  }
+  if (copied < len) {
+    memcpy(dst + copied, gb->buf + gb->gap_end + (pos - gb->gap_start), len - copied);
+  }
+  return len;
+}
+
+char *gap_buffer_to_string(const gap_buffer *gb) {
+  size_t len = gap_buffer_length(gb);
+  char *str = malloc(len + 1);
+  if (str == NULL) {
+    return NULL;
+  }
+  gap_buffer_extract(gb, 0, len, str);
+  str[len] = '\0';
+  return str;
+}
+
+const char *gap_buffer_cstr(gap_buffer *gb) {
+  if (gap_reserve(gb, 1) != 0) {
+    return NULL;
+  }
+  gap_move(gb, gap_buffer_length(gb));
+  gb->buf[gb->gap_start] = '\0';
+  return gb->buf;
+} /* End of gapbuf.c */
@@ -0,0 +1,132 @@
+/** @file gapbuf.h
+ *  @brief Growable text buffer for many edits (gap buffer)
+ *
+ *  @author Georg Pohl
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  The text is kept in one array with a hole (the gap) at the
+ *  position of the last edit. Inserting or erasing at the gap costs
+ *  only the size of the edit; moving to another position costs the
+ *  distance moved. So a run of edits front to back over a config -
+ *  the usual rewrite - is linear in the size of the text plus the
+ *  edits, instead of shifting the whole tail for every single edit
+ *  as 'insert_at_position' and 'erase_from_length' do.
+ *
+ *  All positions are byte offsets into the text, without the gap.
+ *  Functions returning int give 0 on success and -1 if a position is
+ *  out of range or memory is exhausted; the text is unchanged then.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#ifndef GAPBUF_H
+#define GAPBUF_H
+
+#include <stddef.h>
+
+typedef struct {
+  char *buf;
+  size_t cap;
+  size_t gap_start;     /*!< First byte of the gap */
+  size_t gap_end;       /*!< First byte behind the gap */
+} gap_buffer;
+
+/**
+ * Function: gap_buffer_init
+ * Usage: gap_buffer_init(&gb, config, strlen(config))
+ * ---------------------------------------------------
+ * @brief Creates a buffer holding a copy of 'text'
+ * @param gap_buffer *gb
+ * @param const char *text May be NULL if 'len' is 0
+ * @param size_t len
+ * @return int 0 or -1
+ */
+int gap_buffer_init(gap_buffer *gb, const char *text, size_t len);
+
+/**
+ * Function: gap_buffer_free
+ * Usage: gap_buffer_free(&gb)
+ * ---------------------------
+ * @brief Releases the memory of a buffer
+ */
+void gap_buffer_free(gap_buffer *gb);
+
+/**
+ * Function: gap_buffer_length
+ * Usage: size_t len = gap_buffer_length(&gb)
+ * ------------------------------------------
+ * @brief Returns the length of the text
+ */
+size_t gap_buffer_length(const gap_buffer *gb);
+
+/**
+ * Function: gap_buffer_insert
+ * Usage: gap_buffer_insert(&gb, pos, "text", 4)
+ * ---------------------------------------------
+ * @brief Inserts 'len' bytes of 'text' before position 'pos'
+ * @return int 0 or -1
+ *
+ * 'text' may point into the buffer (e.g. into the string from
+ * gap_buffer_cstr); it is then copied to a temporary first.
+ */
+int gap_buffer_insert(gap_buffer *gb, size_t pos, const char *text, size_t len);
+
+/**
+ * Function: gap_buffer_erase
+ * Usage: gap_buffer_erase(&gb, pos, len)
+ * --------------------------------------
+ * @brief Erases 'len' bytes starting at 'pos'
+ * @return int 0 or -1
+ */
+int gap_buffer_erase(gap_buffer *gb, size_t pos, size_t len);
+
+/**
+ * Function: gap_buffer_replace
+ * Usage: gap_buffer_replace(&gb, pos, len, "new", 3)
+ * --------------------------------------------------
+ * @brief Replaces 'len' bytes at 'pos' by 'text_len' bytes of 'text'
+ * @return int 0 or -1
+ *
+ * Like for gap_buffer_insert, 'text' may point into the buffer.
+ */
+int gap_buffer_replace(gap_buffer *gb, size_t pos, size_t len,
+                       const char *text, size_t text_len);
+
+/**
+ * Function: gap_buffer_extract
+ * Usage: n = gap_buffer_extract(&gb, pos, len, dst)
+ * -------------------------------------------------
+ * @brief Copies up to 'len' bytes from 'pos' into 'dst'
+ * @return size_t Number of bytes copied (no NUL is appended)
+ */
+size_t gap_buffer_extract(const gap_buffer *gb, size_t pos, size_t len, char *dst);
+
+/**
+ * Function: gap_buffer_to_string
+ * Usage: char *text = gap_buffer_to_string(&gb)
+ * ---------------------------------------------
+ * @brief Returns the text as a new C string
+ * @return char* To be freed by the caller, NULL if out of memory
+ */
+char *gap_buffer_to_string(const gap_buffer *gb);
+
+/**
+ * Function: gap_buffer_cstr
+ * Usage: const char *text = gap_buffer_cstr(&gb)
+ * ----------------------------------------------
+ * @brief Returns the text as a C string, without copying
+ * @return const char* NULL if out of memory
+ *
+ * The gap is moved to the end and a NUL is put into it. The pointer
+ * is valid until the next edit.
+ */
+const char *gap_buffer_cstr(gap_buffer *gb);
+
+#endif /* GAPBUF_H */
+/* End of gapbuf.h */
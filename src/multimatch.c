@@ -0,0 +1,219 @@
+/** @file multimatch.c
+ *  @brief Multi-pattern matcher (Aho-Corasick)
+ *
+ *  @author Georg Pohl
+ *
+ *  @bug no known bugs
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  The automaton is stored as one flat array of transitions, row by
+ *  row per state, so a scan touches exactly one int per input byte.
+ *  To keep the rows short, the input bytes are first mapped to
+ *  classes: every byte occurring in a pattern gets its own class,
+ *  all other bytes share class 0. In case-insensitive mode both cases
+ *  of a letter map to the same class.
+ *
+ *  Construction builds the trie directly in that table and then
+ *  completes it in breadth-first order: a missing transition of a
+ *  state is the transition of its failure state. Every state knows
+ *  the pattern ending exactly there ('match', identical patterns are
+ *  chained by 'next_same') and the nearest state on its failure chain
+ *  that ends a pattern ('dict'), so reporting only visits states that
+ *  really have output.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "multimatch.h"
+
+/* STRUCTS */
+
+struct multimatch {
+  unsigned char class_of[256];
+  size_t n_classes;
+  size_t n_states;
+  size_t n_patterns;
+  int32_t *delta;       /*!< n_states * n_classes transitions */
+  int32_t *match;       /*!< Per state: pattern ending here, or -1 */
+  int32_t *dict;        /*!< Per state: next state with output on the failure chain, or -1 */
+  int32_t *next_same;   /*!< Per pattern: next identical pattern, or -1 */
+  size_t *lengths;      /*!< Per pattern: its length */
+};
+
+typedef struct {
+  bool *seen;
+  size_t marked;
+} mark_ctx;
+
+/* FUNCTIONS */
+
+static unsigned char fold(unsigned char ch, bool nocase) {
+  return nocase ? (unsigned char)tolower(ch) : ch;
+}
+
+multimatch *multimatch_compile(const char **patterns, size_t n, bool nocase) {
+  multimatch *mm = calloc(1, sizeof(multimatch));
+  if (mm == NULL) {
+    return NULL;
+  }
+  mm->n_patterns = n;
+
+  // Byte classes and the upper bound of states
+  size_t max_states = 1;
+  mm->n_classes = 1;
+  for (size_t p = 0; p < n; ++p) {
+    for (const char *c = patterns[p]; c != NULL && *c != '\0'; ++c) {
+      unsigned char ch = fold((unsigned char)*c, nocase);
+      if (mm->class_of[ch] == 0) {
+        mm->class_of[ch] = (unsigned char)mm->n_classes++;
+      }
+      max_states++;
+    }
+  }
+  if (nocase) {
+    for (int ch = 'A'; ch <= 'Z'; ++ch) {
+      mm->class_of[ch] = mm->class_of[tolower(ch)];
+    }
+  }
+
+  size_t nc = mm->n_classes;
+  mm->delta = malloc(max_states * nc * sizeof(int32_t));
+  mm->match = malloc(max_states * sizeof(int32_t));
+  mm->dict = malloc(max_states * sizeof(int32_t));
+  mm->next_same = malloc((n ? n : 1) * sizeof(int32_t));
+  mm->lengths = malloc((n ? n : 1) * sizeof(size_t));
+  int32_t *fail = malloc(max_states * sizeof(int32_t));
+  int32_t *queue = malloc(max_states * sizeof(int32_t));
+  if (mm->delta == NULL || mm->match == NULL || mm->dict == NULL ||
+      mm->next_same == NULL || mm->lengths == NULL || fail == NULL || queue == NULL) {
+    free(fail);
+    free(queue);
+    multimatch_free(mm);
+    return NULL;
+  }
+
+  // Build the trie, -1 marks a missing transition
+  memset(mm->delta, 0xff, nc * sizeof(int32_t));
+  mm->match[0] = -1;
+  mm->n_states = 1;
+  for (size_t p = 0; p < n; ++p) {
+    int32_t s = 0;
+    size_t len = 0;
+    mm->next_same[p] = -1;
+    for (const char *c = patterns[p]; c != NULL && *c != '\0'; ++c, ++len) {
+      int32_t *t = &mm->delta[s * nc + mm->class_of[(unsigned char)*c]];
+      if (*t < 0) {
+        *t = (int32_t)mm->n_states++;
+        memset(&mm->delta[*t * nc], 0xff, nc * sizeof(int32_t));
+        mm->match[*t] = -1;
+      }
+      s = *t;
+    }
+    mm->lengths[p] = len;
+    if (s != 0) {
+      mm->next_same[p] = mm->match[s];
+      mm->match[s] = (int32_t)p;
+    }
+  }
+
+  // Complete the automaton in breadth-first order
+  size_t head = 0, tail = 0;
+  mm->dict[0] = -1;
+  fail[0] = 0;
+  for (size_t c = 0; c < nc; ++c) {
+    int32_t t = mm->delta[c];
+    if (t < 0) {
+      mm->delta[c] = 0;
+    } else {
+      fail[t] = 0;
+      mm->dict[t] = -1;
+      queue[tail++] = t;
+    }
+  }
+  while (head < tail) {
+    int32_t s = queue[head++];
+    for (size_t c = 0; c < nc; ++c) {
+      int32_t t = mm->delta[s * nc + c];
+      int32_t f = mm->delta[fail[s] * nc + c];
+      if (t < 0) {
+        mm->delta[s * nc + c] = f;
+      } else {
+        fail[t] = f;
+        mm->dict[t] = mm->match[f] >= 0 ? f : mm->dict[f];
+        queue[tail++] = t;
+      }
+    }
+  }
+  free(fail);
+  free(queue);
+
+  // Give back the rows of unused states
+  int32_t *delta = realloc(mm->delta, mm->n_states * nc * sizeof(int32_t));
+  if (delta != NULL) {
+    mm->delta = delta;
+  }
+  return mm;
+}
+
+size_t multimatch_scan(const multimatch *mm, const char *text, size_t len,
+                       multimatch_callback cb, void *ctx) {
+  const int32_t *delta = mm->delta;
+  const size_t nc = mm->n_classes;
+  size_t matches = 0;
+  int32_t s = 0;
+
+  for (size_t i = 0; i < len; ++i) {
+    s = delta[s * nc + mm->class_of[(unsigned char)text[i]]];
+    if (mm->match[s] < 0 && mm->dict[s] < 0) {
+      continue;
+    }
+    for (int32_t t = mm->match[s] >= 0 ? s : mm->dict[s]; t >= 0; t = mm->dict[t]) {
+      for (int32_t p = mm->match[t]; p >= 0; p = mm->next_same[p]) {
+        matches++;
+        if (cb != NULL && cb((size_t)p, i + 1 - mm->lengths[p], ctx) != 0) {
+          return matches;
+        }
+      }
+    }
+  }
+  return matches;
+}
+
+static int mark_pattern(size_t pattern, size_t offset, void *ctx) {
+  mark_ctx *mc = ctx;
+  if (!mc->seen[pattern]) {
+    mc->seen[pattern] = true;
+    mc->marked++;
+  }
+  return 0;
+}
+
+size_t multimatch_mark(const multimatch *mm, const char *text, size_t len,
+                       bool *seen) {
+  mark_ctx mc = { seen, 0 };
+  multimatch_scan(mm, text, len, mark_pattern, &mc);
+  return mc.marked;
+}
+
+void multimatch_free(multimatch *mm) {
+  if (mm == NULL) {
+    return;
+  }
+  free(mm->delta);
+  free(mm->match);
+  free(mm->dict);
+  free(mm->next_same);
+  free(mm->lengths);
+  free(mm);
+} /* End of multimatch.c */
@@ -0,0 +1,100 @@
+/** @file multimatch.h
+ *  @brief Multi-pattern matcher (Aho-Corasick)
+ *
+ *  @author Georg Pohl
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Finds any number of patterns in one pass over a text, instead of
+ *  calling 'search_pattern_in_string' or 'strstr' once per pattern.
+ *  The patterns are compiled once into a deterministic automaton;
+ *  a scan then costs one table lookup per byte of text, no matter
+ *  how many patterns there are.
+ *
+ *  A compiled matcher is read-only while scanning, so one matcher
+ *  can be shared by several threads.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#ifndef MULTIMATCH_H
+#define MULTIMATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct multimatch multimatch;
+
+/**
+ * Type: multimatch_callback
+ * -------------------------
+ * Called for every match with the index of the pattern and the offset
+ * in the text where the match starts. Returning a non-zero value stops
+ * the scan.
+ */
+typedef int (*multimatch_callback)(size_t pattern, size_t offset, void *ctx);
+
+/**
+ * Function: multimatch_compile
+ * Usage: multimatch *mm = multimatch_compile(patterns, n, true)
+ * -------------------------------------------------------------
+ * @brief Compiles a set of patterns into a matcher
+ * @param const char **patterns NUL-terminated patterns
+ * @param size_t n Number of patterns
+ * @param bool nocase Match ASCII letters case-insensitively
+ * @return multimatch* NULL if out of memory
+ *
+ * Empty or NULL patterns never match. The patterns are copied, they
+ * needn't outlive the matcher.
+ */
+multimatch *multimatch_compile(const char **patterns, size_t n, bool nocase);
+
+/**
+ * Function: multimatch_scan
+ * Usage: matches = multimatch_scan(mm, line, len, callback, ctx)
+ * --------------------------------------------------------------
+ * @brief Reports all matches in a text
+ * @param const multimatch *mm
+ * @param const char *text
+ * @param size_t len
+ * @param multimatch_callback cb
+ * @param void *ctx Passed to 'cb'
+ * @return size_t Number of matches reported
+ *
+ * Overlapping matches are all reported, ordered by their end in the
+ * text.
+ */
+size_t multimatch_scan(const multimatch *mm, const char *text, size_t len,
+                       multimatch_callback cb, void *ctx);
+
+/**
+ * Function: multimatch_mark
+ * Usage: found = multimatch_mark(mm, line, len, seen)
+ * ---------------------------------------------------
+ * @brief Marks which patterns occur in a text
+ * @param const multimatch *mm
+ * @param const char *text
+ * @param size_t len
+ * @param bool *seen Array of one flag per pattern, set to true on a match
+ * @return size_t Number of patterns newly marked
+ *
+ * 'seen' is not cleared, so it can collect the patterns of many lines.
+ */
+size_t multimatch_mark(const multimatch *mm, const char *text, size_t len,
+                       bool *seen);
+
+/**
+ * Function: multimatch_free
+ * Usage: multimatch_free(mm)
+ * --------------------------
+ * @brief Releases a matcher
+ */
+void multimatch_free(multimatch *mm);
+
+#endif /* MULTIMATCH_H */
+/* End of multimatch.h */
@@ -0,0 +1,360 @@
+/** @file probe.c
+ *  @brief Native reachability probes (ICMP echo / TCP connect)
+ *
+ *  @author Georg Pohl
+ *
+ *  @bug no known bugs
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Every probe occupies one slot (socket, send time, kind). Free
+ *  slots are kept on a stack, the epoll user data of a socket is its
+ *  slot index.
+ *
+ *  All probes share the same timeout and are started in host order,
+ *  so their deadlines are ascending with the host index. Expiring
+ *  probes therefore needs no timer heap: 'oldest' is the lowest host
+ *  index which may still be pending, and only the probes from there
+ *  on have to be checked. epoll_wait() sleeps until the deadline of
+ *  that oldest probe at most.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "probe.h"
+
+#ifdef __linux__
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* CONSTANTS */
+
+#define PROBE_DEFAULT_TIMEOUT 1000
+#define PROBE_DEFAULT_PORT 22
+#define PROBE_DEFAULT_INFLIGHT 1024
+#define PROBE_MAX_EVENTS 256
+
+#define ICMP_ECHO_REQUEST 8
+#define ICMP_ECHO_REPLY 0
+#define ICMP6_ECHO_REQUEST 128
+#define ICMP6_ECHO_REPLY 129
+
+/* STRUCTS */
+
+typedef struct {
+  int fd;
+  size_t host;          /*!< Index into hosts/results */
+  int reply_type;       /*!< Expected ICMP type, -1 for TCP */
+  double sent;          /*!< Monotonic time in ms */
+} probe_slot;
+
+/* FUNCTIONS */
+
+static double monotonic_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Internet checksum (RFC 1071) */
+static unsigned short icmp_checksum(const unsigned char *buf, size_t len) {
+  unsigned long sum = 0;
+  for (size_t i = 0; i + 1 < len; i += 2) {
+    sum += (buf[i] << 8) | buf[i + 1];
+  }
+  if (len & 1) {
+    sum += buf[len - 1] << 8;
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return (unsigned short)~sum;
+}
+
+static bool is_unreachable_errno(int err) {
+  return err == EHOSTUNREACH || err == ENETUNREACH || err == EHOSTDOWN ||
+         err == ENETDOWN || err == EADDRNOTAVAIL;
+}
+
+/* Opens an ICMP datagram socket and sends one echo request */
+static int icmp_start(const struct addrinfo *ai, int *reply_type,
+                      probe_status *status) {
+  bool v6 = ai->ai_family == AF_INET6;
+  int fd = socket(ai->ai_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  v6 ? IPPROTO_ICMPV6 : IPPROTO_ICMP);
+  if (fd < 0) {
+    return -1;
+  }
+
+  // Identifier is set by the kernel for ping sockets
+  unsigned char packet[16] = { 0 };
+  packet[0] = v6 ? ICMP6_ECHO_REQUEST : ICMP_ECHO_REQUEST;
+  packet[7] = 1;
+  if (!v6) {
+    unsigned short sum = icmp_checksum(packet, sizeof(packet));
+    packet[2] = sum >> 8;
+    packet[3] = sum & 0xff;
+  }
+  if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0 ||
+      send(fd, packet, sizeof(packet), 0) < 0) {
+    *status = is_unreachable_errno(errno) ? PROBE_UNREACHABLE : PROBE_ERROR;
+    close(fd);
+    return -2;
+  }
+  *reply_type = v6 ? ICMP6_ECHO_REPLY : ICMP_ECHO_REPLY;
+  return fd;
+}
+
+/* Starts a non-blocking TCP connect to 'port' */
+static int tcp_start(struct addrinfo *ai, unsigned short port,
+                     probe_status *status) {
+  if (ai->ai_family == AF_INET6) {
+    ((struct sockaddr_in6 *)ai->ai_addr)->sin6_port = htons(port);
+  } else {
+    ((struct sockaddr_in *)ai->ai_addr)->sin_port = htons(port);
+  }
+  int fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    *status = PROBE_ERROR;
+    return -2;
+  }
+  if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == ECONNREFUSED) {
+    *status = PROBE_REACHABLE;
+  } else if (errno == EINPROGRESS) {
+    return fd;
+  } else {
+    *status = is_unreachable_errno(errno) ? PROBE_UNREACHABLE : PROBE_ERROR;
+  }
+  close(fd);
+  return -2;
+}
+
+/**
+ * Starts the probe of 'host'. Returns the socket to wait for, or -2
+ * if the probe is already finished; then 'result->status' holds the
+ * result. 'result->method' records what was tried last. Once the
+ * kernel refuses ICMP sockets, PROBE_AUTO switches to TCP for the
+ * rest of the run.
+ */
+static int probe_start(const char *host, const probe_options *opts,
+                       bool *icmp_denied, int *reply_type, probe_result *result) {
+  probe_status *status = &result->status;
+  struct addrinfo hints, *ai;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (host == NULL || getaddrinfo(host, NULL, &hints, &ai) != 0) {
+    *status = PROBE_ERROR;
+    return -2;
+  }
+
+  int fd = -1;
+  *reply_type = -1;
+  if (opts->method != PROBE_TCP && !*icmp_denied) {
+    result->method = PROBE_ICMP;
+    fd = icmp_start(ai, reply_type, status);
+    if (fd == -1) {
+      if (opts->method == PROBE_AUTO &&
+          (errno == EACCES || errno == EPERM || errno == EPROTONOSUPPORT ||
+           errno == EAFNOSUPPORT)) {
+        *icmp_denied = true;
+      } else {
+        *status = PROBE_ERROR;
+        fd = -2;
+      }
+    }
+  }
+  if (fd == -1) {
+    result->method = PROBE_TCP;
+    fd = tcp_start(ai, opts->tcp_port, status);
+  }
+  freeaddrinfo(ai);
+  return fd;
+}
+
+/* Evaluates an event on a probe socket, PROBE_PENDING means keep waiting */
+static probe_status probe_event(const probe_slot *slot) {
+  if (slot->reply_type < 0) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(slot->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err == 0 || err == ECONNREFUSED) {
+      return PROBE_REACHABLE;
+    }
+    return is_unreachable_errno(err) ? PROBE_UNREACHABLE : PROBE_ERROR;
+  }
+
+  unsigned char reply[128];
+  ssize_t got;
+  while ((got = recv(slot->fd, reply, sizeof(reply), 0)) >= 0) {
+    if (got > 0 && reply[0] == slot->reply_type) {
+      return PROBE_REACHABLE;
+    }
+  }
+  if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    return PROBE_PENDING;
+  }
+  return is_unreachable_errno(errno) || errno == ECONNREFUSED
+             ? PROBE_UNREACHABLE : PROBE_ERROR;
+}
+
+int probe_hosts(const char **hosts, size_t n, probe_result *results,
+                const probe_options *opts) {
+  if (hosts == NULL || results == NULL) {
+    return -1;
+  }
+  probe_options o = { PROBE_AUTO, 0, 0, 0 };
+  if (opts != NULL) {
+    o = *opts;
+  }
+  if (o.timeout_ms == 0) {
+    o.timeout_ms = PROBE_DEFAULT_TIMEOUT;
+  }
+  if (o.tcp_port == 0) {
+    o.tcp_port = PROBE_DEFAULT_PORT;
+  }
+  if (o.max_inflight == 0) {
+    o.max_inflight = PROBE_DEFAULT_INFLIGHT;
+  }
+  if (o.max_inflight > n) {
+    o.max_inflight = n ? (unsigned int)n : 1;
+  }
+
+  int ep = epoll_create1(EPOLL_CLOEXEC);
+  probe_slot *slots = malloc(o.max_inflight * sizeof(probe_slot));
+  unsigned int *free_slots = malloc(o.max_inflight * sizeof(unsigned int));
+  unsigned int *slot_of = malloc((n ? n : 1) * sizeof(unsigned int));
+  if (ep < 0 || slots == NULL || free_slots == NULL || slot_of == NULL) {
+    fprintf(stderr, "probe_hosts: can't set up the probe engine\n");
+    if (ep >= 0) {
+      close(ep);
+    }
+    free(slots);
+    free(free_slots);
+    free(slot_of);
+    return -1;
+  }
+  unsigned int n_free = o.max_inflight;
+  for (unsigned int s = 0; s < o.max_inflight; ++s) {
+    free_slots[s] = o.max_inflight - 1 - s;
+  }
+
+  struct epoll_event events[PROBE_MAX_EVENTS];
+  bool icmp_denied = false;
+  size_t next = 0, oldest = 0;
+  int up = 0;
+
+  while (next < n || n_free < o.max_inflight) {
+    // Fill all free slots with new probes
+    while (next < n && n_free > 0) {
+      size_t h = next++;
+      probe_slot *slot = &slots[free_slots[n_free - 1]];
+      results[h].status = PROBE_PENDING;
+      results[h].rtt_ms = 0.0;
+      results[h].method = PROBE_AUTO;
+      slot->sent = monotonic_ms();
+      slot->fd = probe_start(hosts[h], &o, &icmp_denied, &slot->reply_type,
+                             &results[h]);
+      if (slot->fd < 0) {
+        if (results[h].status == PROBE_REACHABLE) {
+          results[h].rtt_ms = monotonic_ms() - slot->sent;
+          up++;
+        }
+        continue;
+      }
+      struct epoll_event ev;
+      ev.events = slot->reply_type < 0 ? EPOLLOUT : EPOLLIN;
+      ev.data.u32 = free_slots[n_free - 1];
+      if (epoll_ctl(ep, EPOLL_CTL_ADD, slot->fd, &ev) != 0) {
+        close(slot->fd);
+        results[h].status = PROBE_ERROR;
+        continue;
+      }
+      slot->host = h;
+      slot_of[h] = free_slots[--n_free];
+    }
+    if (n_free == o.max_inflight) {
+      continue;
+    }
+
+    // Sleep until the oldest probe expires at most
+    while (results[oldest].status != PROBE_PENDING) {
+      oldest++;
+    }
+    double wait = slots[slot_of[oldest]].sent + o.timeout_ms - monotonic_ms();
+    int nev = epoll_wait(ep, events, PROBE_MAX_EVENTS, wait > 0 ? (int)wait + 1 : 0);
+
+    for (int e = 0; e < nev; ++e) {
+      unsigned int s = events[e].data.u32;
+      probe_status status = probe_event(&slots[s]);
+      if (status == PROBE_PENDING) {
+        continue;
+      }
+      probe_result *r = &results[slots[s].host];
+      r->status = status;
+      if (status == PROBE_REACHABLE) {
+        r->rtt_ms = monotonic_ms() - slots[s].sent;
+        up++;
+      }
+      close(slots[s].fd);
+      free_slots[n_free++] = s;
+    }
+
+    // Expire timed out probes, their deadlines ascend with the index
+    double now = monotonic_ms();
+    for (; oldest < next; ++oldest) {
+      if (results[oldest].status != PROBE_PENDING) {
+        continue;
+      }
+      unsigned int s = slot_of[oldest];
+      if (now - slots[s].sent < o.timeout_ms) {
+        break;
+      }
+      results[oldest].status = PROBE_TIMEOUT;
+      close(slots[s].fd);
+      free_slots[n_free++] = s;
+    }
+  }
+
+  close(ep);
+  free(slots);
+  free(free_slots);
+  free(slot_of);
+  return up;
+}
+
+#else /* !__linux__ */
+
+int probe_hosts(const char **hosts, size_t n, probe_result *results,
+                const probe_options *opts) {
+  for (size_t i = 0; results != NULL && i < n; ++i) {
+    results[i].status = PROBE_ERROR;
+    results[i].rtt_ms = 0.0;
+    results[i].method = PROBE_AUTO;
+  }
+  return -1;
+}
+
+#endif /* __linux__ */
+
+bool probe_host(const char *hostname, unsigned int timeout_ms) {
+  probe_options opts = { PROBE_AUTO, timeout_ms, 0, 1 };
+  probe_result result;
+  return probe_hosts(&hostname, 1, &result, &opts) == 1;
+} /* End of probe.c */
@@ -0,0 +1,96 @@
+/** @file probe.h
+ *  @brief Native reachability probes (ICMP echo / TCP connect)
+ *
+ *  @author Georg Pohl
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Checks the reachability of many hosts from a single thread,
+ *  without starting a 'ping' process per host. Every probe is a
+ *  non-blocking socket; all sockets in flight are multiplexed with
+ *  epoll. ICMP datagram ("ping") sockets are used where the kernel
+ *  permits them (net.ipv4.ping_group_range), otherwise a TCP
+ *  connect to a configurable port is made. A refused connection
+ *  counts as reachable, because the host did answer. A host which
+ *  drops the port times out although it may answer a ping; the
+ *  'method' of the result tells such timeouts apart.
+ *
+ *  Only available on Linux; elsewhere 'probe_hosts' returns -1.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Probe methods */
+typedef enum {
+  PROBE_AUTO,           /*!< ICMP if permitted, TCP otherwise */
+  PROBE_ICMP,           /*!< ICMP echo only */
+  PROBE_TCP             /*!< TCP connect only */
+} probe_method;
+
+/* Outcome of a single probe */
+typedef enum {
+  PROBE_PENDING,        /*!< Not finished (only seen during the run) */
+  PROBE_REACHABLE,      /*!< Host answered, 'rtt_ms' is valid */
+  PROBE_UNREACHABLE,    /*!< Host or network reported as unreachable */
+  PROBE_TIMEOUT,        /*!< No answer within the timeout */
+  PROBE_ERROR           /*!< Name not resolvable or socket error */
+} probe_status;
+
+typedef struct {
+  probe_status status;
+  double rtt_ms;        /*!< Round trip time in milliseconds */
+  probe_method method;  /*!< PROBE_ICMP or PROBE_TCP as sent, PROBE_AUTO if none */
+} probe_result;
+
+typedef struct {
+  probe_method method;
+  unsigned int timeout_ms;    /*!< Per probe, 0 for the default (1000) */
+  unsigned short tcp_port;    /*!< 0 for the default (22) */
+  unsigned int max_inflight;  /*!< 0 for the default (1024) */
+} probe_options;
+
+/**
+ * Function: probe_hosts
+ * Usage: up = probe_hosts(hosts, n, results, &opts)
+ * -------------------------------------------------
+ * @brief Probes many hosts concurrently from one thread
+ * @param const char **hosts IP addresses or hostnames
+ * @param size_t n Number of hosts
+ * @param probe_result *results Array of 'n' results
+ * @param const probe_options *opts NULL for the defaults
+ * @return int Number of reachable hosts, -1 on error
+ *
+ * Up to 'max_inflight' probes are in flight at any time. Hostnames
+ * are resolved with getaddrinfo() right before their probe is sent,
+ * so pass addresses for large sweeps.
+ */
+int probe_hosts(const char **hosts, size_t n, probe_result *results,
+                const probe_options *opts);
+
+/**
+ * Function: probe_host
+ * Usage: probe_host("192.0.2.1", 1000)
+ * ------------------------------------
+ * @brief Probes a single host with the default options
+ * @param const char *hostname
+ * @param unsigned int timeout_ms
+ * @return bool true if reachable
+ *
+ * Has the signature of a 'reachability_probe', so it can be passed to
+ * 'sweep_reachability' in ganylib.h.
+ */
+bool probe_host(const char *hostname, unsigned int timeout_ms);
+
+#endif /* PROBE_H */
+/* End of probe.h */
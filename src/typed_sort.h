@@ -0,0 +1,393 @@
+/** @file typed_sort.h
+ *  @brief Type-specialized sort, search and merge ("templates")
+ *
+ *  @author Georg Pohl
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  'qsort' and 'bsearch' call the comparison through a function
+ *  pointer for every single comparison. The macros below instead
+ *  stamp out a complete set of functions for one element type, with
+ *  the comparison written into the code, so the compiler sees (and
+ *  optimizes) every comparison. Typical use in a .c file:
+ *
+ *    #define BY_UPTIME(r) ((r).uptime_minutes)
+ *    TYPED_SORT_DEFINE_BY_KEY(static, records, uptime_record, long,
+ *                             BY_UPTIME, TYPED_SORT_LESS)
+ *
+ *  which defines records_sort(), records_lower_bound() etc.
+ *
+ *  The sort is an introsort in the style of pdqsort:
+ *
+ *  - The pivot is the median of three (of three medians of three for
+ *    more than TYPED_SORT_NINTHER elements).
+ *  - Partitioning is a branchless Lomuto scheme: every element is
+ *    exchanged with the boundary slot unconditionally and the boundary
+ *    advances by the result of the comparison, so there is no branch
+ *    to mispredict on random data.
+ *  - A partition whose predecessor (an earlier pivot, which is not
+ *    greater than anything in it) equals the new pivot puts all
+ *    elements equal to the pivot on the left and skips them, so many
+ *    duplicates cost linear time instead of degrading.
+ *  - A partition which leaves less than 1/8 on one side is bad: a
+ *    few elements of both sides are exchanged to break up the pattern
+ *    which caused it (e.g. organ pipes). After log2(n) bad partitions
+ *    heapsort takes over, which bounds the worst case to O(N log N).
+ *  - A part which is already in order (or in reverse order, then it
+ *    is reversed) is recognized before a pivot is chosen, so sorted
+ *    input costs linear time. On unsorted data the check stops at the
+ *    first change of direction.
+ *  - Below TYPED_SORT_CUTOFF elements insertion sort takes over.
+ *
+ *  The smaller side is sorted recursively, the larger one in the loop,
+ *  so the stack depth is at most log2(n). The searches halve the range
+ *  without an early exit, so the loop has a fixed trip count and the
+ *  compiler can turn the comparison into a conditional move. As the
+ *  loop doesn't know which half it will take, it prefetches the next
+ *  probe of both; on arrays larger than the cache one of the two loads
+ *  is then already under way.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#ifndef TYPED_SORT_H
+#define TYPED_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TYPED_SORT_CUTOFF 24
+#define TYPED_SORT_NINTHER 128
+
+/* Ready-made comparison and key for plain numbers */
+#define TYPED_SORT_LESS(a, b) ((a) < (b))
+#define TYPED_SORT_IDENTITY(x) (x)
+
+#ifdef __GNUC__
+#define TYPED_SORT_UNUSED __attribute__((unused))
+#define TYPED_SORT_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define TYPED_SORT_UNUSED
+#define TYPED_SORT_PREFETCH(p) ((void)0)
+#endif
+
+/**
+ * Macro: TYPED_SORT_DEFINE
+ * Usage: TYPED_SORT_DEFINE(static, latency, double, TYPED_SORT_LESS)
+ * ------------------------------------------------------------------
+ * @brief Defines sort, search and merge functions for type 'T'
+ * @param SCOPE Storage class of the functions, usually 'static'
+ * @param NAME Prefix of the function names
+ * @param T Element type
+ * @param LESS Function-like macro (or function) LESS(a, b), true if
+ * 'a' goes before 'b'; it must be a strict weak ordering
+ *
+ * Defines:
+ *   void NAME_sort(T *a, size_t n)
+ *   void NAME_sort_counted(T *a, size_t n, size_t *swaps)
+ *   bool NAME_is_sorted(const T *a, size_t n)
+ *   size_t NAME_lower_bound(const T *a, size_t n, T key)
+ *   size_t NAME_upper_bound(const T *a, size_t n, T key)
+ *   ptrdiff_t NAME_find(const T *a, size_t n, T key)
+ *   void NAME_merge(const T *a, size_t na, const T *b, size_t nb, T *out)
+ *   size_t NAME_merge_split(const T *a, size_t na, const T *b, size_t nb,
+ *                           size_t d)
+ *
+ * The sort is not stable; 'swaps' receives the no. of exchanges.
+ * 'lower_bound' returns the first index whose element is not less
+ * than 'key', 'upper_bound' the first one greater than 'key' (both
+ * 'n' if there is none), 'find' the index of an element equal to
+ * 'key' or -1. 'merge' merges two sorted arrays stably (equal
+ * elements of 'a' first) into 'out', which holds na + nb elements
+ * and must not overlap the inputs. 'merge_split' tells how many of
+ * the first 'd' merged elements come from 'a' (binary search, no
+ * merging); so a merge can be cut into independent pieces, e.g. one
+ * per thread.
+ */
+#define TYPED_SORT_DEFINE(SCOPE, NAME, T, LESS)                               \
+  TYPED_SORT_DEFINE_BY_KEY(SCOPE, NAME, T, T, TYPED_SORT_IDENTITY, LESS)
+
+/**
+ * Macro: TYPED_SORT_DEFINE_BY_KEY
+ * Usage: TYPED_SORT_DEFINE_BY_KEY(static, records, uptime_record, long, BY_UPTIME, TYPED_SORT_LESS)
+ * -------------------------------------------------------------------------------------------------
+ * @brief Like TYPED_SORT_DEFINE, but orders by a key of the elements
+ * @param K Key type
+ * @param KEY Function-like macro (or function) KEY(x) returning the
+ * key of element 'x' (passed as a value, not a pointer)
+ * @param LESS Comparison of two keys
+ *
+ * The searches take a key instead of an element:
+ *   size_t NAME_lower_bound(const T *a, size_t n, K key), etc.
+ */
+#define TYPED_SORT_DEFINE_BY_KEY(SCOPE, NAME, T, K, KEY, LESS)                \
+static void NAME##_ts_swap(T *x, T *y, size_t *swaps) {                       \
+  T tmp = *x;                                                                 \
+  *x = *y;                                                                    \
+  *y = tmp;                                                                   \
+  ++*swaps;                                                                   \
+}                                                                             \
+                                                                              \
+static void NAME##_ts_insertion(T *a, size_t n, size_t *swaps) {              \
+  for (size_t i = 1; i < n; ++i) {                                            \
+    T val = a[i];                                                             \
+    size_t j = i;                                                             \
+    for (; j > 0 && LESS(KEY(val), KEY(a[j - 1])); --j) {                     \
+      a[j] = a[j - 1];                                                        \
+    }                                                                         \
+    a[j] = val;                                                               \
+    *swaps += i - j;                                                          \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+/* Sorts 'a' if it is in order or in reverse order */                         \
+static bool NAME##_ts_presorted(T *a, size_t n, size_t *swaps) {              \
+  size_t i = 1;                                                               \
+  if (LESS(KEY(a[1]), KEY(a[0]))) {                                           \
+    while (i < n && !LESS(KEY(a[i - 1]), KEY(a[i]))) {                        \
+      i++;                                                                    \
+    }                                                                         \
+    if (i < n) {                                                              \
+      return false;                                                           \
+    }                                                                         \
+    for (size_t lo = 0, hi = n - 1; lo < hi; ++lo, --hi) {                    \
+      NAME##_ts_swap(a + lo, a + hi, swaps);                                  \
+    }                                                                         \
+    return true;                                                              \
+  }                                                                           \
+  while (i < n && !LESS(KEY(a[i]), KEY(a[i - 1]))) {                          \
+    i++;                                                                      \
+  }                                                                           \
+  return i == n;                                                              \
+}                                                                             \
+                                                                              \
+static void NAME##_ts_sift_down(T *a, size_t root, size_t n, size_t *swaps) { \
+  T val = a[root];                                                            \
+  size_t child;                                                               \
+  while ((child = 2 * root + 1) < n) {                                        \
+    if (child + 1 < n && LESS(KEY(a[child]), KEY(a[child + 1]))) {            \
+      child++;                                                                \
+    }                                                                         \
+    if (!LESS(KEY(val), KEY(a[child]))) {                                     \
+      break;                                                                  \
+    }                                                                         \
+    a[root] = a[child];                                                       \
+    root = child;                                                             \
+    ++*swaps;                                                                 \
+  }                                                                           \
+  a[root] = val;                                                              \
+}                                                                             \
+                                                                              \
+static void NAME##_ts_heap_sort(T *a, size_t n, size_t *swaps) {              \
+  for (size_t i = n / 2; i > 0; --i) {                                        \
+    NAME##_ts_sift_down(a, i - 1, n, swaps);                                  \
+  }                                                                           \
+  for (size_t end = n - 1; end > 0; --end) {                                  \
+    NAME##_ts_swap(a, a + end, swaps);                                        \
+    NAME##_ts_sift_down(a, 0, end, swaps);                                    \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+/* Orders *x <= *y <= *z */                                                   \
+static void NAME##_ts_sort3(T *x, T *y, T *z, size_t *swaps) {                \
+  if (LESS(KEY(*y), KEY(*x))) {                                               \
+    NAME##_ts_swap(x, y, swaps);                                              \
+  }                                                                           \
+  if (LESS(KEY(*z), KEY(*y))) {                                               \
+    NAME##_ts_swap(y, z, swaps);                                              \
+  }                                                                           \
+  if (LESS(KEY(*y), KEY(*x))) {                                               \
+    NAME##_ts_swap(x, y, swaps);                                              \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+/* Partitions around a[0]; with 'equal_left' elements equal to the      */    \
+/* pivot go left. Returns the final position of the pivot.              */    \
+static size_t NAME##_ts_partition(T *a, size_t n, bool equal_left,            \
+                                  size_t *swaps) {                            \
+  T pivot = a[0];                                                             \
+  size_t i = 1, moved = 0;                                                    \
+  for (size_t j = 1; j < n; ++j) {                                            \
+    T x = a[j];                                                               \
+    size_t left = equal_left ? !LESS(KEY(pivot), KEY(x))                      \
+                             : LESS(KEY(x), KEY(pivot));                      \
+    a[j] = a[i];                                                              \
+    a[i] = x;                                                                 \
+    moved += left & (i != j);                                                 \
+    i += left;                                                                \
+  }                                                                           \
+  a[0] = a[i - 1];                                                            \
+  a[i - 1] = pivot;                                                           \
+  *swaps += moved + 1;                                                        \
+  return i - 1;                                                               \
+}                                                                             \
+                                                                              \
+/* Exchanges a few elements around both ends of a bad partition side */     \
+static void NAME##_ts_break_pattern(T *a, size_t n, size_t *swaps) {          \
+  NAME##_ts_swap(a, a + n / 4, swaps);                                        \
+  NAME##_ts_swap(a + n - 1, a + n - n / 4, swaps);                            \
+  if (n > TYPED_SORT_NINTHER) {                                               \
+    NAME##_ts_swap(a + 1, a + n / 4 + 1, swaps);                              \
+    NAME##_ts_swap(a + 2, a + n / 4 + 2, swaps);                              \
+    NAME##_ts_swap(a + n - 2, a + n - n / 4 - 1, swaps);                      \
+    NAME##_ts_swap(a + n - 3, a + n - n / 4 - 2, swaps);                      \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+static void NAME##_ts_loop(T *a, size_t n, unsigned int bad_allowed,          \
+                           bool leftmost, size_t *swaps) {                    \
+  while (n > TYPED_SORT_CUTOFF) {                                             \
+    if (NAME##_ts_presorted(a, n, swaps)) {                                   \
+      return;                                                                 \
+    }                                                                         \
+    size_t h = n / 2;                                                         \
+    if (n > TYPED_SORT_NINTHER) {                                             \
+      NAME##_ts_sort3(a, a + h, a + n - 1, swaps);                            \
+      NAME##_ts_sort3(a + 1, a + h - 1, a + n - 2, swaps);                    \
+      NAME##_ts_sort3(a + 2, a + h + 1, a + n - 3, swaps);                    \
+      NAME##_ts_sort3(a + h - 1, a + h, a + h + 1, swaps);                    \
+      NAME##_ts_swap(a, a + h, swaps);                                        \
+    } else {                                                                  \
+      NAME##_ts_sort3(a + h, a, a + n - 1, swaps);                            \
+    }                                                                         \
+    if (!leftmost && !LESS(KEY(a[-1]), KEY(a[0]))) {                          \
+      size_t p = NAME##_ts_partition(a, n, true, swaps) + 1;                  \
+      a += p;                                                                 \
+      n -= p;                                                                 \
+      continue;                                                               \
+    }                                                                         \
+    size_t p = NAME##_ts_partition(a, n, false, swaps);                       \
+    size_t l = p, r = n - p - 1;                                              \
+    if (l < n / 8 || r < n / 8) {                                             \
+      if (--bad_allowed == 0) {                                               \
+        NAME##_ts_heap_sort(a, n, swaps);                                     \
+        return;                                                               \
+      }                                                                       \
+      if (l >= TYPED_SORT_CUTOFF) {                                           \
+        NAME##_ts_break_pattern(a, l, swaps);                                 \
+      }                                                                       \
+      if (r >= TYPED_SORT_CUTOFF) {                                           \
+        NAME##_ts_break_pattern(a + p + 1, r, swaps);                         \
+      }                                                                       \
+    }                                                                         \
+    if (l < r) {                                                              \
+      NAME##_ts_loop(a, l, bad_allowed, leftmost, swaps);                     \
+      a += p + 1;                                                             \
+      n = r;                                                                  \
+      leftmost = false;                                                       \
+    } else {                                                                  \
+      NAME##_ts_loop(a + p + 1, r, bad_allowed, false, swaps);                \
+      n = l;                                                                  \
+    }                                                                         \
+  }                                                                           \
+  NAME##_ts_insertion(a, n, swaps);                                           \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE void NAME##_sort_counted(T *a, size_t n, size_t *swaps) {               \
+  size_t count = 0;                                                           \
+  unsigned int bad_allowed = 1;                                               \
+  for (size_t m = n; m > 1; m >>= 1) {                                        \
+    bad_allowed++;                                                            \
+  }                                                                           \
+  if (n > 1) {                                                                \
+    NAME##_ts_loop(a, n, bad_allowed, true, &count);                          \
+  }                                                                           \
+  if (swaps != NULL) {                                                        \
+    *swaps = count;                                                           \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE void NAME##_sort(T *a, size_t n) {                                      \
+  NAME##_sort_counted(a, n, NULL);                                            \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE bool NAME##_is_sorted(const T *a, size_t n) {                           \
+  for (size_t i = 1; i < n; ++i) {                                            \
+    if (LESS(KEY(a[i]), KEY(a[i - 1]))) {                                     \
+      return false;                                                           \
+    }                                                                         \
+  }                                                                           \
+  return true;                                                                \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE size_t NAME##_lower_bound(const T *a, size_t n, K key) {                \
+  const T *base = a;                                                          \
+  if (n == 0) {                                                               \
+    return 0;                                                                 \
+  }                                                                           \
+  while (n > 1) {                                                             \
+    size_t half = n / 2;                                                      \
+    TYPED_SORT_PREFETCH(base + (n - half) / 2);                               \
+    TYPED_SORT_PREFETCH(base + half + (n - half) / 2);                        \
+    base = LESS(KEY(base[half - 1]), key) ? base + half : base;               \
+    n -= half;                                                                \
+  }                                                                           \
+  return (size_t)(base - a) + LESS(KEY(*base), key);                          \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE size_t NAME##_upper_bound(const T *a, size_t n, K key) {                \
+  const T *base = a;                                                          \
+  if (n == 0) {                                                               \
+    return 0;                                                                 \
+  }                                                                           \
+  while (n > 1) {                                                             \
+    size_t half = n / 2;                                                      \
+    TYPED_SORT_PREFETCH(base + (n - half) / 2);                               \
+    TYPED_SORT_PREFETCH(base + half + (n - half) / 2);                        \
+    base = !LESS(key, KEY(base[half - 1])) ? base + half : base;              \
+    n -= half;                                                                \
+  }                                                                           \
+  return (size_t)(base - a) + !LESS(key, KEY(*base));                         \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE ptrdiff_t NAME##_find(const T *a, size_t n, K key) {                    \
+  size_t i = NAME##_lower_bound(a, n, key);                                   \
+  return i < n && !LESS(key, KEY(a[i])) ? (ptrdiff_t)i : -1;                  \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE void NAME##_merge(const T *a, size_t na, const T *b, size_t nb,         \
+                        T *out) {                                             \
+  size_t i = 0, j = 0, k = 0;                                                 \
+  while (i < na && j < nb) {                                                  \
+    bool take_b = LESS(KEY(b[j]), KEY(a[i]));                                 \
+    out[k++] = take_b ? b[j] : a[i];                                          \
+    j += take_b;                                                              \
+    i += !take_b;                                                             \
+  }                                                                           \
+  while (i < na) {                                                            \
+    out[k++] = a[i++];                                                        \
+  }                                                                           \
+  while (j < nb) {                                                            \
+    out[k++] = b[j++];                                                        \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+TYPED_SORT_UNUSED                                                             \
+SCOPE size_t NAME##_merge_split(const T *a, size_t na, const T *b, size_t nb, \
+                                size_t d) {                                   \
+  size_t lo = d > nb ? d - nb : 0, hi = d < na ? d : na;                      \
+  while (lo < hi) {                                                           \
+    size_t i = lo + (hi - lo) / 2;                                            \
+    if (LESS(KEY(b[d - i - 1]), KEY(a[i]))) {                                 \
+      hi = i;                                                                 \
+    } else {                                                                  \
+      lo = i + 1;                                                             \
+    }                                                                         \
+  }                                                                           \
+  return lo;                                                                  \
+}
+
+#endif /* TYPED_SORT_H */
+/* End of typed_sort.h */
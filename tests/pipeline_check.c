@@ -0,0 +1,231 @@
+/** @file pipeline_check.c
+ *  @brief Serial and parallel file processing give the same results
+ *
+ *  @author Georg Pohl
+ *
+ *  @bug no known bugs
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Writes a file of about 9 MB (several chunks per thread) with
+ *  "\r\n" lines, a few long lines and a last line without '\n'.
+ *  'line_pipeline_run_parallel', 'file_search' and
+ *  'remove_entries_from_file' are run on 1, 4 and 5 threads; every
+ *  output has to be identical to the serial one. Run with 'make
+ *  check' in src/.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ganylib.h"
+
+/* CONSTANTS */
+
+#define CHECK_LINES 300000
+#define CHECK_LONG_EVERY 50000
+#define CHECK_LONG_LEN 5000
+#define CHECK_STOP_LINE 260000  /* In one of the last chunks */
+
+/* FUNCTIONS */
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  failures += !ok;
+}
+
+static void make_temp(char *fn) {
+  strcpy(fn, "/tmp/pipeline_checkXXXXXX");
+  int fd = mkstemp(fn);
+  if (fd < 0) {
+    perror("mkstemp");
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+}
+
+static char *read_file(const char *fn, size_t *len) {
+  FILE *fp = fopen(fn, "rb");
+  char *buf = NULL;
+  *len = 0;
+  if (fp != NULL && fseek(fp, 0, SEEK_END) == 0) {
+    long size = ftell(fp);
+    rewind(fp);
+    buf = malloc(size > 0 ? size : 1);
+    if (buf != NULL) {
+      *len = fread(buf, 1, size, fp);
+    }
+  }
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  return buf;
+}
+
+static bool same_files(const char *a, const char *b) {
+  size_t la, lb;
+  char *da = read_file(a, &la), *db = read_file(b, &lb);
+  bool same = da != NULL && db != NULL && la == lb && memcmp(da, db, la) == 0;
+  free(da);
+  free(db);
+  return same;
+}
+
+static void write_input(const char *fn) {
+  FILE *fp = fopen(fn, "wb");
+  if (fp == NULL) {
+    perror(fn);
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < CHECK_LINES; ++i) {
+    if (i == CHECK_STOP_LINE) {
+      fprintf(fp, "STOP here\n");
+    }
+    fprintf(fp, "host%07zu.example.net 10.%zu.%zu.%zu up %zu", i, i >> 16 & 255,
+            i >> 8 & 255, i & 255, i * 7);
+    if (i % CHECK_LONG_EVERY == 0) {
+      for (size_t k = 0; k < CHECK_LONG_LEN; ++k) {
+        fputc('a' + k % 26, fp);
+      }
+    }
+    if (i + 1 < CHECK_LINES) {
+      fputs(i % 7 == 0 ? "\r\n" : "\n", fp);
+    }
+  }
+  fclose(fp);
+}
+
+/* Drops, rewrites or keeps a line depending on the last digit of its host */
+static int edit_line(text_span line, line_sink *out, void *ctx) {
+  if (line.len < 11 || memcmp(line.ptr, "host", 4) != 0) {
+    return ctx != NULL && line.len >= 4 && memcmp(line.ptr, "STOP", 4) == 0;
+  }
+  switch (line.ptr[10]) {
+    case '1':
+    case '2':
+      return 0;
+    case '3': {
+      char buf[64];
+      size_t len = line.len < 40 ? line.len : 40;
+      for (size_t k = 0; k < len; ++k) {
+        buf[k] = line.ptr[len - 1 - k];
+      }
+      buf[len] = '\n';
+      return line_sink_write(out, buf, len + 1) != 0;
+    }
+    default:
+      return line_sink_keep(out) != 0;
+  }
+}
+
+static void check_pipeline(const char *in, bool stop) {
+  char serial[32], parallel[32], what[96];
+  make_temp(serial);
+  make_temp(parallel);
+  void *ctx = stop ? (void *)serial : NULL;
+  long expect = line_pipeline_run(in, serial, edit_line, ctx);
+  check(expect > 0, "line_pipeline_run");
+  for (unsigned int threads = 4; threads <= 5; ++threads) {
+    long got = line_pipeline_run_parallel(in, parallel, threads, edit_line, ctx);
+    snprintf(what, sizeof(what), "line_pipeline_run_parallel, %u threads%s",
+             threads, stop ? ", stopped late" : "");
+    check(got == expect && same_files(serial, parallel), what);
+  }
+  unlink(serial);
+  unlink(parallel);
+}
+
+static void check_file_search(const char *in) {
+  static const char *queries[][4] = {
+    { "host0000005.", "", "", "10.0.0.5" },
+    { "host0299999.", "", "", "10.4.147.223" },   /* Last line, no '\n' */
+    { "host0270001.", "up", "10.", "10.4.30.177" },
+    { "STOP", "", "", "here" },
+    { "host02", "up", "abcdefghij", "10.3.13.64" }, /* Long line */
+    { "host0123456.", "missing", "", NULL }
+  };
+  file_search *fs = file_search_open(in);
+  check(fs != NULL, "file_search_open");
+  if (fs == NULL) {
+    return;
+  }
+  for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); ++q) {
+    text_span expect = { NULL, 0 }, got;
+    file_search_set_threads(fs, 1);
+    bool found = file_search_query(fs, 2, queries[q][0], queries[q][1],
+                                   queries[q][2], &expect);
+    bool same = queries[q][3] == NULL
+                    ? !found
+                    : found && expect.len == strlen(queries[q][3]) &&
+                      memcmp(expect.ptr, queries[q][3], expect.len) == 0;
+    for (unsigned int threads = 4; threads <= 5; ++threads) {
+      got.ptr = NULL;
+      got.len = 0;
+      file_search_set_threads(fs, threads);
+      same &= file_search_query(fs, 2, queries[q][0], queries[q][1],
+                                queries[q][2], &got) == found &&
+              got.ptr == expect.ptr && got.len == expect.len;
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "file_search_query \"%s\" on 1, 4 and 5 threads",
+             queries[q][0]);
+    check(same, what);
+  }
+  file_search_close(fs);
+}
+
+static void check_remove(const char *in) {
+  static const char *entries[] = {
+    "host0000001.example.net 10.0.0.1 up 7",
+    "HOST0000007.EXAMPLE.NET 10.0.0.7 UP 49",     /* "\r\n" line, any case */
+    "host0299999.example.net 10.4.147.223 up 2099993",
+    "host0200000.example.net",                    /* Prefix only: kept */
+    "STOP here"
+  };
+  size_t n = sizeof(entries) / sizeof(entries[0]);
+  size_t hits_serial[5] = { 0 }, hits_parallel[5] = { 0 };
+  char serial[32], parallel[32];
+  make_temp(serial);
+  make_temp(parallel);
+  size_t len;
+  char *data = read_file(in, &len);
+  FILE *a = fopen(serial, "wb"), *b = fopen(parallel, "wb");
+  fwrite(data, 1, len, a);
+  fwrite(data, 1, len, b);
+  fclose(a);
+  fclose(b);
+  free(data);
+
+  long expect = remove_entries_from_file(serial, entries, n, hits_serial, 1);
+  long got = remove_entries_from_file(parallel, entries, n, hits_parallel, 4);
+  check(expect == 4 && hits_serial[3] == 0, "remove_entries_from_file, serial");
+  check(got == expect && memcmp(hits_serial, hits_parallel, sizeof(hits_serial)) == 0 &&
+        same_files(serial, parallel), "remove_entries_from_file, 4 threads");
+  unlink(serial);
+  unlink(parallel);
+}
+
+int main(void) {
+  char in[32];
+  make_temp(in);
+  write_input(in);
+
+  check_pipeline(in, false);
+  check_pipeline(in, true);
+  check_file_search(in);
+  check_remove(in);
+
+  unlink(in);
+  printf("%d failure(s)\n", failures);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+} /* End of pipeline_check.c */
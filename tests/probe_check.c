@@ -0,0 +1,136 @@
+/** @file probe_check.c
+ *  @brief Loopback checks of the probe engine (probe.h)
+ *
+ *  @author Georg Pohl
+ *
+ *  @bug no known bugs
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Needs no network: all probes go to 127.0.0.1. A listening and a
+ *  closed TCP port must both count as reachable, a name that can't
+ *  be resolved as an error. Run with 'make check' in src/.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ganylib.h"
+#include "probe.h"
+
+/* CONSTANTS */
+
+#define CHECK_MANY 1000
+#define CHECK_FILL 3
+
+/* FUNCTIONS */
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  failures += !ok;
+}
+
+/* Opens a listening socket on an ephemeral loopback port */
+static int listen_loopback(unsigned short *port, int backlog) {
+  struct sockaddr_in addr = { 0 };
+  socklen_t len = sizeof(addr);
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(fd, backlog) != 0 ||
+      getsockname(fd, (struct sockaddr *)&addr, &len) != 0) {
+    perror("listen_loopback");
+    exit(EXIT_FAILURE);
+  }
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+/*
+ * A port which drops SYNs like a filter: a listener whose accept
+ * queue is full. Its clients are left in 'clients'.
+ */
+static int filtered_loopback(unsigned short *port, int clients[CHECK_FILL]) {
+  int fd = listen_loopback(port, 0);
+  struct sockaddr_in addr = { 0 };
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(*port);
+  for (int i = 0; i < CHECK_FILL; ++i) {
+    clients[i] = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    connect(clients[i], (struct sockaddr *)&addr, sizeof(addr));
+  }
+  usleep(100000);
+  return fd;
+}
+
+int main(void) {
+  const char *loopback = "127.0.0.1";
+  unsigned short port;
+  int fd = listen_loopback(&port, CHECK_MANY);
+  probe_options tcp = { PROBE_TCP, 1000, port, 0 };
+  probe_result r;
+
+  check(probe_hosts(&loopback, 1, &r, &tcp) == 1 && r.status == PROBE_REACHABLE &&
+        r.rtt_ms >= 0.0, "TCP probe of a listening port");
+
+  const char **many = malloc(CHECK_MANY * sizeof(const char *));
+  probe_result *results = malloc(CHECK_MANY * sizeof(probe_result));
+  for (size_t i = 0; i < CHECK_MANY; ++i) {
+    many[i] = loopback;
+  }
+  tcp.max_inflight = 256;
+  check(probe_hosts(many, CHECK_MANY, results, &tcp) == CHECK_MANY,
+        "1000 TCP probes, 256 in flight");
+  close(fd);
+
+  check(probe_hosts(&loopback, 1, &r, &tcp) == 1 && r.status == PROBE_REACHABLE,
+        "TCP probe of a closed port (refused)");
+
+  probe_options automatic = { PROBE_AUTO, 1000, port, 0 };
+  check(probe_hosts(&loopback, 1, &r, &automatic) == 1, "ICMP or TCP probe");
+
+  int clients[CHECK_FILL];
+  fd = filtered_loopback(&port, clients);
+  probe_options filtered = { PROBE_TCP, 300, port, 0 };
+  check(probe_hosts(&loopback, 1, &r, &filtered) == 0 && r.status == PROBE_TIMEOUT &&
+        r.method == PROBE_TCP, "TCP probe of a filtered port (timeout)");
+  filtered.method = PROBE_AUTO;
+  probe_hosts(&loopback, 1, &r, &filtered);
+  check((r.status == PROBE_REACHABLE && r.method == PROBE_ICMP) ||
+        (r.status == PROBE_TIMEOUT && r.method == PROBE_TCP),
+        "ICMP or TCP probe of a filtered port (timeout is marked TCP)");
+  for (int i = 0; i < CHECK_FILL; ++i) {
+    close(clients[i]);
+  }
+  close(fd);
+
+  const char *invalid = "host.invalid";
+  check(probe_hosts(&invalid, 1, &r, NULL) == 0 && r.status == PROBE_ERROR,
+        "unresolvable name");
+
+  check(device_is_reachable((char *)loopback), "device_is_reachable");
+
+  const char *hosts[3] = { loopback, NULL, loopback };
+  bool up[3];
+  check(sweep_reachability(hosts, 3, up, 0, 1000, NULL) == 2 && up[0] && !up[1] &&
+        up[2], "sweep_reachability");
+
+  free(many);
+  free(results);
+  printf("%d failure(s)\n", failures);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+} /* End of probe_check.c */
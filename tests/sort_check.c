@@ -0,0 +1,342 @@
+/** @file sort_check.c
+ *  @brief The sorts and sorted-array searches against qsort and a scan
+ *
+ *  @author Georg Pohl
+ *
+ *  @bug no known bugs
+ *
+ *  Date of creation: 18-10-2026
+ *
+ *  Version: 1.0
+ *
+ *  Last change: 18-10-2026
+ *
+ *  -------------------------------------
+ *  Every sort is run on random, narrow-range, sorted, reversed and
+ *  constant data of several sizes (also the edge cases 0, 1 and the
+ *  small-array cutoffs) and compared element by element with
+ *  qsort(). The searches are compared with a linear scan for
+ *  every element of the array, its neighbours and the extremes.
+ *  Run with 'make check' in src/.
+ *
+ *  Copyright (C) 2026: Georg Pohl, 70174 Stuttgart
+ */
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ganylib.h"
+
+/* CONSTANTS */
+
+#define CHECK_SHAPES 5
+#define CHECK_PARALLEL_N (1 << 19)  /* 64K per thread needed to split */
+#define CHECK_PARALLEL_MAX_THREADS 5
+
+static const size_t check_sizes[] = { 0, 1, 2, 3, 31, 32, 33, 1000, 70000 };
+
+/* FUNCTIONS */
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  failures += !ok;
+}
+
+/* xorshift64, so the data is the same on every run */
+static unsigned long long check_state = 88172645463325252ULL;
+
+static unsigned int check_rand(void) {
+  check_state ^= check_state << 13;
+  check_state ^= check_state >> 7;
+  check_state ^= check_state << 17;
+  return (unsigned int)(check_state >> 32);
+}
+
+/* Shape 0: full int range, 1: narrow range with many duplicates,
+   2: sorted, 3: reversed, 4: constant */
+static void fill_ints(int *a, size_t n, int shape) {
+  for (size_t i = 0; i < n; ++i) {
+    switch (shape) {
+      case 0: a[i] = (int)check_rand(); break;
+      case 1: a[i] = (int)(check_rand() % 100) - 50; break;
+      case 2: a[i] = (int)i - 500; break;
+      case 3: a[i] = INT_MAX - (int)i; break;
+      default: a[i] = 7; break;
+    }
+  }
+}
+
+static int cmp_int(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+typedef void (*int_sort)(int *array, size_t n);
+
+/* Runs 'sort' on every shape and size, compares with qsort() */
+static void check_int_sort(int_sort sort, const char *name) {
+  size_t max = check_sizes[sizeof(check_sizes) / sizeof(check_sizes[0]) - 1];
+  int *a = malloc(max * sizeof(int)), *b = malloc(max * sizeof(int));
+  bool ok = a != NULL && b != NULL;
+  for (int shape = 0; ok && shape < CHECK_SHAPES; ++shape) {
+    for (size_t s = 0; ok && s < sizeof(check_sizes) / sizeof(check_sizes[0]); ++s) {
+      size_t n = check_sizes[s];
+      fill_ints(a, n, shape);
+      memcpy(b, a, n * sizeof(int));
+      sort(a, n);
+      qsort(b, n, sizeof(int), cmp_int);
+      ok = memcmp(a, b, n * sizeof(int)) == 0;
+    }
+  }
+  check(ok, name);
+  free(a);
+  free(b);
+}
+
+static void do_radix_sort(int *a, size_t n) {
+  radix_sort(a, n, NULL);
+}
+
+static void do_radix_sort_scratch(int *a, size_t n) {
+  int *scratch = malloc((n ? n : 1) * sizeof(int));
+  radix_sort(a, n, scratch);
+  free(scratch);
+}
+
+static void do_integer_sort(int *a, size_t n) {
+  integer_sort(a, n);
+}
+
+/* Counts narrow ranges only, the full int range would take 32 GB */
+static void do_counting_sort(int *a, size_t n) {
+  int min = INT_MAX, max = INT_MIN;
+  for (size_t i = 0; i < n; ++i) {
+    min = a[i] < min ? a[i] : min;
+    max = a[i] > max ? a[i] : max;
+  }
+  if (n > 0 && (long long)max - min > (1 << 20)) {
+    qsort(a, n, sizeof(int), cmp_int);
+  } else if (counting_sort_checked(a, n) != 0) {
+    fprintf(stderr, "counting_sort_checked: out of memory\n");
+  }
+}
+
+static void do_intro_sort(int *a, size_t n) {
+  intro_sort(a, n, NULL);
+}
+
+static void do_shell_sort(int *a, size_t n) {
+  shell_sort(a, (int)n);
+}
+
+static void do_insertion_sort(int *a, size_t n) {
+  if (n <= 1000) {              /* Quadratic */
+    insertion_sort(a, (int)n);
+  } else {
+    qsort(a, n, sizeof(int), cmp_int);
+  }
+}
+
+/* NaNs sort last, like 'intro_sort_double' puts them */
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  if (isnan(x) || isnan(y)) {
+    return isnan(x) - isnan(y);
+  }
+  return (x > y) - (x < y);
+}
+
+typedef void (*double_sort)(double *array, size_t n);
+
+/* Like 'check_int_sort'; every 97th value of the random shape is a NaN */
+static void check_double_sort(double_sort sort, const char *name) {
+  size_t max = check_sizes[sizeof(check_sizes) / sizeof(check_sizes[0]) - 1];
+  int *ints = malloc(max * sizeof(int));
+  double *a = malloc(max * sizeof(double)), *b = malloc(max * sizeof(double));
+  bool ok = ints != NULL && a != NULL && b != NULL;
+  for (int shape = 0; ok && shape < CHECK_SHAPES; ++shape) {
+    for (size_t s = 0; ok && s < sizeof(check_sizes) / sizeof(check_sizes[0]); ++s) {
+      size_t n = check_sizes[s];
+      fill_ints(ints, n, shape);
+      for (size_t i = 0; i < n; ++i) {
+        a[i] = shape == 0 && i % 97 == 96 ? NAN : ints[i] / 8.0;
+      }
+      memcpy(b, a, n * sizeof(double));
+      sort(a, n);
+      qsort(b, n, sizeof(double), cmp_double);
+      for (size_t i = 0; ok && i < n; ++i) {
+        ok = isnan(b[i]) ? isnan(a[i]) : memcmp(&a[i], &b[i], sizeof(double)) == 0;
+      }
+    }
+  }
+  check(ok, name);
+  free(ints);
+  free(a);
+  free(b);
+}
+
+static void do_intro_sort_double(double *a, size_t n) {
+  intro_sort_double(a, n, NULL);
+}
+
+/* 'parallel_sort' on 2 to 5 threads, large enough to use all of them */
+static void check_parallel_sort(void) {
+  size_t n = CHECK_PARALLEL_N;
+  int *src = malloc(n * sizeof(int)), *a = malloc(n * sizeof(int));
+  int *b = malloc(n * sizeof(int));
+  double *d = malloc(n * sizeof(double)), *e = malloc(n * sizeof(double));
+  bool ok = src != NULL && a != NULL && b != NULL, ok_double = d != NULL && e != NULL;
+  for (int shape = 0; ok && ok_double && shape < CHECK_SHAPES; ++shape) {
+    fill_ints(src, n, shape);
+    memcpy(b, src, n * sizeof(int));
+    qsort(b, n, sizeof(int), cmp_int);
+    for (size_t i = 0; i < n; ++i) {
+      e[i] = shape == 0 && i % 97 == 96 ? NAN : src[i] / 8.0;
+    }
+    qsort(e, n, sizeof(double), cmp_double);
+    for (unsigned int t = 2; t <= CHECK_PARALLEL_MAX_THREADS; ++t) {
+      memcpy(a, src, n * sizeof(int));
+      parallel_sort(a, n, t);
+      ok &= memcmp(a, b, n * sizeof(int)) == 0;
+      for (size_t i = 0; i < n; ++i) {
+        d[i] = shape == 0 && i % 97 == 96 ? NAN : src[i] / 8.0;
+      }
+      parallel_sort_double(d, n, t);
+      for (size_t i = 0; ok_double && i < n; ++i) {
+        ok_double = isnan(e[i]) ? isnan(d[i]) : memcmp(&d[i], &e[i], sizeof(double)) == 0;
+      }
+    }
+  }
+  check(ok, "parallel_sort, 2 to 5 threads");
+  check(ok_double, "parallel_sort_double, 2 to 5 threads, NaNs last");
+  free(src);
+  free(a);
+  free(b);
+  free(d);
+  free(e);
+}
+
+static void do_parallel_sort(int *a, size_t n) {
+  parallel_sort(a, n, 0);
+}
+
+static size_t linear_lower_bound(const int *arr, size_t n, int key) {
+  size_t i = 0;
+  while (i < n && arr[i] < key) {
+    i++;
+  }
+  return i;
+}
+
+/* Keys to look up in 'arr': every element and its neighbours, the extremes */
+static size_t lookup_keys(const int *arr, size_t n, int *keys) {
+  size_t m = 0;
+  keys[m++] = INT_MIN;
+  keys[m++] = INT_MAX;
+  for (size_t i = 0; i < n; ++i) {
+    keys[m++] = arr[i];
+    keys[m++] = arr[i] == INT_MIN ? arr[i] : arr[i] - 1;
+    keys[m++] = arr[i] == INT_MAX ? arr[i] : arr[i] + 1;
+  }
+  return m;
+}
+
+/* Sizes around powers of two, where the Eytzinger tree gets a new level */
+static const size_t lookup_sizes[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17,
+                                       31, 32, 33, 100, 1000, 4097 };
+
+typedef bool (*lookup_check)(const int *arr, size_t n, const int *keys, size_t m);
+
+/* Runs 'lookup' on sorted distinct, duplicate-heavy and constant arrays */
+static void check_lookup(lookup_check lookup, const char *name) {
+  size_t max = lookup_sizes[sizeof(lookup_sizes) / sizeof(lookup_sizes[0]) - 1];
+  int *arr = malloc(max * sizeof(int)), *keys = malloc((3 * max + 2) * sizeof(int));
+  bool ok = arr != NULL && keys != NULL;
+  for (int shape = 0; ok && shape < CHECK_SHAPES; ++shape) {
+    for (size_t s = 0; ok && s < sizeof(lookup_sizes) / sizeof(lookup_sizes[0]); ++s) {
+      size_t n = lookup_sizes[s];
+      fill_ints(arr, n, shape);
+      qsort(arr, n, sizeof(int), cmp_int);
+      ok = lookup(arr, n, keys, lookup_keys(arr, n, keys));
+    }
+  }
+  check(ok, name);
+  free(arr);
+  free(keys);
+}
+
+static bool bounds_lookup(const int *arr, size_t n, const int *keys, size_t m) {
+  for (size_t k = 0; k < m; ++k) {
+    size_t lo = linear_lower_bound(arr, n, keys[k]), hi = lo;
+    while (hi < n && arr[hi] == keys[k]) {
+      hi++;
+    }
+    if (lower_bound_int(arr, n, keys[k]) != lo || upper_bound_int(arr, n, keys[k]) != hi) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool eytzinger_lookup(const int *arr, size_t n, const int *keys, size_t m) {
+  eytzinger_index ix;
+  size_t *out = malloc((m ? m : 1) * sizeof(size_t));
+  bool ok = out != NULL && eytzinger_build(&ix, arr, n) == 0;
+  if (!ok) {
+    free(out);
+    return false;
+  }
+  eytzinger_lower_bound_batch(&ix, keys, m, out);
+  for (size_t k = 0; ok && k < m; ++k) {
+    size_t lo = linear_lower_bound(arr, n, keys[k]);
+    ptrdiff_t found = eytzinger_find(&ix, keys[k]);
+    ok = eytzinger_lower_bound(&ix, keys[k]) == lo && out[k] == lo &&
+         (lo < n && arr[lo] == keys[k] ? found >= 0 && arr[found] == keys[k] : found == -1);
+  }
+  eytzinger_free(&ix);
+  free(out);
+  return ok;
+}
+
+static bool batch_lookup(const int *arr, size_t n, const int *keys, size_t m) {
+  size_t *out = malloc((m ? m : 1) * sizeof(size_t)), hits = 0;
+  ptrdiff_t *found = malloc((m ? m : 1) * sizeof(ptrdiff_t));
+  bool ok = out != NULL && found != NULL;
+  if (ok) {
+    lower_bound_int_batch(arr, n, keys, m, out);
+    size_t got = find_in_sorted_array_batch(arr, n, keys, m, found);
+    for (size_t k = 0; ok && k < m; ++k) {
+      size_t lo = linear_lower_bound(arr, n, keys[k]);
+      bool hit = lo < n && arr[lo] == keys[k];
+      hits += hit;
+      ok = out[k] == lo && found[k] == (hit ? (ptrdiff_t)lo : -1);
+    }
+    ok &= got == hits;
+  }
+  free(out);
+  free(found);
+  return ok;
+}
+
+int main(void) {
+  check_int_sort(do_radix_sort, "radix_sort");
+  check_int_sort(do_radix_sort_scratch, "radix_sort with scratch buffer");
+  check_int_sort(do_integer_sort, "integer_sort");
+  check_int_sort(do_counting_sort, "counting_sort_checked");
+  check_int_sort(do_intro_sort, "intro_sort");
+  check_int_sort(do_shell_sort, "shell_sort");
+  check_int_sort(do_insertion_sort, "insertion_sort");
+  check_double_sort(do_intro_sort_double, "intro_sort_double, NaNs last");
+  check_int_sort(do_parallel_sort, "parallel_sort, small arrays");
+  check_parallel_sort();
+  check_lookup(bounds_lookup, "lower_bound_int, upper_bound_int");
+  check_lookup(eytzinger_lookup, "eytzinger_lower_bound, _find and _batch");
+  check_lookup(batch_lookup, "lower_bound_int_batch, find_in_sorted_array_batch");
+
+  printf("%d failure(s)\n", failures);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+} /* End of sort_check.c */